@@ -4,19 +4,103 @@
 
 #include <windows.h>
 #include <random>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <d3d11.h>
+#include <d3dcompiler.h>
+#include <dwmapi.h>
+#include <wtsapi32.h>
+#include <ShellScalingApi.h>
+#include <TraceLoggingProvider.h>
+#include <shlobj.h>
+#include <wincodec.h>
+#include <mfapi.h>
+#include <mfidl.h>
+#include <mfreadwrite.h>
+#include <algorithm>
+#include <cstdarg>
+
+#pragma comment(lib, "d3d11.lib")
+#pragma comment(lib, "d3dcompiler.lib")
+#pragma comment(lib, "dwmapi.lib")
+#pragma comment(lib, "wtsapi32.lib")
+#pragma comment(lib, "shcore.lib")
+#pragma comment(lib, "ole32.lib")
+#pragma comment(lib, "windowscodecs.lib")
+#pragma comment(lib, "mfplat.lib")
+#pragma comment(lib, "mfreadwrite.lib")
+#pragma comment(lib, "mfuuid.lib")
+#include <intrin.h>
+#include <immintrin.h>
 
 // ---- Config / registry keys
 static LPCWSTR REG_KEY = L"Software\\StarfieldScreensaver";
 static LPCWSTR REG_STARS = L"StarCount";
 static LPCWSTR REG_SPEED = L"SpeedPercent";
+static LPCWSTR REG_RENDERER = L"Renderer"; // 0 = GDI, 1 = DIB, 2 = D3D11
+static LPCWSTR REG_FPS = L"TargetFps";      // 0 = follow the display refresh
+static LPCWSTR REG_INCREMENTAL = L"Incremental"; // GDI/DIB: erase and blit only changed bands
+static LPCWSTR REG_RECYCLE = L"RecycleOffscreen"; // respawn stars that left the view cone
+static LPCWSTR REG_ANALYTIC = L"Analytic";        // depth as a function of time, star array read-only
+static LPCWSTR REG_SHARED = L"SharedField";       // one field across the virtual desktop
+static LPCWSTR REG_STREAKS = L"Streaks";          // motion streaks instead of discs
+static LPCWSTR REG_COMPACT = L"CompactStars";     // 7-byte packed stars (implies Analytic)
+static LPCWSTR REG_LOD_PIXEL = L"LodPixel";       // GDI/DIB: radius drawn as a single pixel, 0 = none
+static LPCWSTR REG_LOD_QUAD = L"LodQuad";         // GDI/DIB: radius drawn as a 2x2 quad
+static LPCWSTR REG_GOVERNOR = L"Governor";        // trade quality for frame time on slow machines
+
+// AVX2 kernels are picked at runtime; GCC/Clang need the target enabled per function
+#if defined(__GNUC__) || defined(__clang__)
+#define STAR_TARGET_AVX2 __attribute__((target("avx,avx2")))
+#else
+#define STAR_TARGET_AVX2
+#endif
+
+// ETW provider for the frame stats (TraceLogging, view with WPR / tracelog)
+TRACELOGGING_DEFINE_PROVIDER(g_TraceProvider, "MyStarfield",
+    (0x6b1f3c2e, 0x8d4a, 0x4e57, 0x9a, 0x31, 0x2c, 0x5e, 0x7d, 0x9b, 0x0f, 0x14));
 
 // Defaults
-static int g_StarCount = 3000;
-static int g_Speed = 10;
-static int g_MaxStars = 5000;
+// g_StarCount, g_Speed, g_Incremental, g_Streaks, the LOD tiers and g_Governor change while
+// workers run (hot reload)
+static std::atomic<int> g_StarCount{ 3000 };
+static std::atomic<int> g_Speed{ 10 };
+static int g_MaxStars = 200000; // DIB / D3D11 paths handle far more than GDI Ellipse
 static int g_MaxSpeed = 300;
+static int g_TargetFps = 0;
+static std::atomic<bool> g_Incremental{ true };
+static bool g_RecycleOffscreen = false;
+static bool g_Analytic = false;
+static bool g_SharedField = false;
+static std::atomic<bool> g_Streaks{ false };
+static bool g_Compact = false;
+// largest drawn star radius in pixels
+static constexpr int MAX_PSZ = 128;
+// LOD tiers (GDI/DIB): radius <= g_LodPixel is one pixel, <= g_LodQuad a 2x2 quad, the rest
+// a disc / glow sprite
+static std::atomic<int> g_LodPixel{ 1 };
+static std::atomic<int> g_LodQuad{ 2 };
+static std::atomic<bool> g_Governor{ true }; // fullscreen: quality governor, see QualityGovernor
+static bool g_ShowHud = false; // /hud on the command line
+static bool g_CapturePng = false;  // /png: capture to a PNG sequence instead of .mp4
+static bool g_CaptureLive = false; // /capture: record the primary monitor while the saver runs
 static COLORREF g_Color = RGB(255, 255, 255);// Star Color!
 
+// Render path: RENDER_D3D11 draws instanced point sprites on the GPU,
+// RENDER_DIB splats stars into a DIB section ourselves,
+// RENDER_GDI is the classic one Ellipse call per star (and the last fallback)
+enum RenderPath { RENDER_GDI = 0, RENDER_DIB = 1, RENDER_D3D11 = 2 };
+static RenderPath g_RenderPath = RENDER_D3D11;
+
 // Registry helpers
 static int GetRegDWORD(LPCWSTR name, int def)
 {
@@ -39,10 +123,29 @@ static void SetRegDWORD(LPCWSTR name, DWORD v)
         RegCloseKey(hKey);
     }
 }
-static void LoadSettings()
+// Settings a running saver picks up (ReloadSettings), the rest apply on the next start
+static void LoadLiveSettings()
 {
     g_StarCount = GetRegDWORD(REG_STARS, g_StarCount);
     g_Speed = GetRegDWORD(REG_SPEED, g_Speed);
+    g_TargetFps = max(0, min(1000, GetRegDWORD(REG_FPS, g_TargetFps)));
+    g_Incremental = GetRegDWORD(REG_INCREMENTAL, g_Incremental ? 1 : 0) != 0;
+    g_Streaks = GetRegDWORD(REG_STREAKS, g_Streaks ? 1 : 0) != 0;
+    int lodPixel = max(0, min(MAX_PSZ, GetRegDWORD(REG_LOD_PIXEL, g_LodPixel)));
+    g_LodQuad = max(lodPixel, min(MAX_PSZ, GetRegDWORD(REG_LOD_QUAD, g_LodQuad)));
+    g_LodPixel = lodPixel;
+    g_Governor = GetRegDWORD(REG_GOVERNOR, g_Governor ? 1 : 0) != 0;
+}
+static void LoadSettings()
+{
+    LoadLiveSettings();
+    g_RecycleOffscreen = GetRegDWORD(REG_RECYCLE, g_RecycleOffscreen ? 1 : 0) != 0;
+    g_Analytic = GetRegDWORD(REG_ANALYTIC, g_Analytic ? 1 : 0) != 0;
+    g_SharedField = GetRegDWORD(REG_SHARED, g_SharedField ? 1 : 0) != 0;
+    g_Compact = GetRegDWORD(REG_COMPACT, g_Compact ? 1 : 0) != 0;
+    if (g_Compact) g_Analytic = true; // packed stars are written once, at spawn
+    int path = GetRegDWORD(REG_RENDERER, g_RenderPath);
+    if (path >= RENDER_GDI && path <= RENDER_D3D11) g_RenderPath = (RenderPath)path;
 }
 static void SaveSettings()
 {
@@ -50,15 +153,276 @@ static void SaveSettings()
     SetRegDWORD(REG_SPEED, (DWORD)g_Speed);
 }
 
-// Star model
-struct Star
+// Aligned, 8-padded buffer for the SIMD kernels (64 bytes = one cache line)
+template <typename T>
+struct AlignedBuffer
+{
+    T* data = nullptr;
+    int capacity = 0;
+    AlignedBuffer() {}
+    AlignedBuffer(const AlignedBuffer&) = delete;
+    AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+    ~AlignedBuffer() { _aligned_free(data); }
+    // grow to at least n elements, keeping the first 'keep' ones
+    void reserve(int n, int keep = 0)
+    {
+        n = (n + 7) & ~7;
+        if (n <= capacity) return;
+        T* p = (T*)_aligned_malloc((size_t)n * sizeof(T), 64);
+        if (!p) throw std::bad_alloc();
+        if (data && keep > 0) memcpy(p, data, (size_t)min(keep, capacity) * sizeof(T));
+        _aligned_free(data);
+        data = p;
+        capacity = n;
+    }
+    T& operator[](int i) { return data[i]; }
+    const T& operator[](int i) const { return data[i]; }
+};
+
+// Star model: structure of arrays so the kernel can load 8 stars per register.
+// The compact layout (CompactStars = 1) packs a star into 7 bytes instead of 16 and the
+// kernels unpack it on the fly; it is only written at spawn, so it always runs analytic.
+struct StarSoA
+{
+    AlignedBuffer<float> x;     // world X (centered)
+    AlignedBuffer<float> y;     // world Y (centered)
+    AlignedBuffer<float> z;     // depth
+    AlignedBuffer<float> speed; // per-star speed (depth units / second or arbitrary units)
+    // compact layout
+    AlignedBuffer<int16_t> qx, qy;  // world X / Y in steps of qScaleX / qScaleY
+    AlignedBuffer<uint16_t> qz;     // spawn depth above Z_MIN in steps of Z_QSTEP
+    AlignedBuffer<uint8_t> qspeed;  // speed above qSpeed0, the whole-step jitter
+    bool compact = false;
+    float qScaleX = 0.0f, qScaleY = 0.0f;
+    float qSpeed0 = 0.0f;
+    int count = 0;
+    int size() const { return count; }
+    void clear() { count = 0; }
+    void resize(int n)
+    {
+        if (compact)
+        {
+            qx.reserve(n, count);
+            qy.reserve(n, count);
+            qz.reserve(n, count);
+            qspeed.reserve(n, count);
+        }
+        else
+        {
+            x.reserve(n, count);
+            y.reserve(n, count);
+            z.reserve(n, count);
+            speed.reserve(n, count);
+        }
+        count = n;
+    }
+};
+
+// Respawn RNG: four xoshiro128+ streams stepped side by side, so a refill of the
+// float buffer runs 4-wide on SSE2. Respawns only read floats from the buffer.
+static const int RNG_BUF = 256;
+struct StarRng
+{
+    uint32_t s[4][4] = {}; // s[word][stream]
+    float buf[RNG_BUF];    // uniform [0, 1)
+    int pos = RNG_BUF;
+
+    void Seed(uint64_t seed)
+    {
+        // splitmix64 expands the seed into the 16 state words
+        for (int k = 0; k < 16; k += 2)
+        {
+            uint64_t z = (seed += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            z ^= z >> 31;
+            s[k / 4][k % 4] = (uint32_t)z;
+            s[(k + 1) / 4][(k + 1) % 4] = (uint32_t)(z >> 32);
+        }
+        pos = RNG_BUF;
+    }
+    void Fill(); // after the SIMD detection
+    float Next01()
+    {
+        if (pos == RNG_BUF) Fill();
+        return buf[pos++];
+    }
+};
+
+// brightness buckets, one brush / color per bucket
+static constexpr int BUCKETS = 6;
+
+// Screen-space output of the simulate pass, only visible stars, consumed by the draw pass
+struct ProjectedStars
+{
+    AlignedBuffer<float> px;
+    AlignedBuffer<float> py;
+    AlignedBuffer<uint8_t> psz;    // radius 1..MAX_PSZ
+    AlignedBuffer<uint8_t> bucket; // 0..BUCKETS-1
+    AlignedBuffer<float> tx;       // streaks: position one frame earlier
+    AlignedBuffer<float> ty;
+    int count = 0;
+    bool tails = false;            // tx / ty are valid this frame
+    void reserve(int n)
+    {
+        px.reserve(n);
+        py.reserve(n);
+        psz.reserve(n);
+        bucket.reserve(n);
+        tx.reserve(n);
+        ty.reserve(n);
+    }
+};
+
+// Renderer backend: owns a window's backbuffer (or swap chain), draws rw->proj into it
+// and presents. See GdiRenderer / D3D11Renderer below.
+struct RenderWindow;
+struct CaptureRing;
+struct StarRenderer
+{
+    virtual ~StarRenderer() {}
+    virtual RenderPath Path() const = 0;
+    // (re)create for the current rw->rc
+    virtual bool Create(RenderWindow* rw) = 0;
+    virtual void Destroy(RenderWindow* rw) = 0;
+    virtual bool IsReady(const RenderWindow* rw) const = 0;
+    // clear and draw rw->proj
+    virtual void Draw(RenderWindow* rw) = 0;
+    // HUD text on top of the frame, after Draw
+    virtual void DrawOverlay(RenderWindow* rw, const char* text) = 0;
+    virtual void Present(RenderWindow* rw) = 0;
+    // block until the next vertical blank of this window's output, false if unsupported
+    virtual bool WaitForVBlank() { return false; }
+    // copy the top left w x h of the frame just drawn (after Draw, before Present) into
+    // dst as top-down BGRX rows of w pixels, false if it can't
+    virtual bool ReadFrame(RenderWindow* rw, uint32_t* dst, int w, int h) = 0;
+};
+
+// ---- Frame-time instrumentation
+enum Phase { PHASE_SIMULATE = 0, PHASE_DRAW, PHASE_PRESENT, PHASE_PUMP, PHASE_FRAME, PHASE_COUNT };
+static const char* g_PhaseNames[PHASE_COUNT] = { "sim", "draw", "blit", "pump", "frame" };
+
+struct PhaseSummary { float p50, p95, p99, min, max; };
+
+// Rolling window of the last STATS_WINDOW samples (ms) per phase
+static const int STATS_WINDOW = 240;
+struct FrameStats
+{
+    float samples[PHASE_COUNT][STATS_WINDOW] = {};
+    int count[PHASE_COUNT] = {};
+    int head[PHASE_COUNT] = {};
+
+    void Add(Phase p, float ms)
+    {
+        samples[p][head[p]] = ms;
+        head[p] = (head[p] + 1) % STATS_WINDOW;
+        if (count[p] < STATS_WINDOW) ++count[p];
+    }
+    PhaseSummary Summarize(Phase p) const
+    {
+        PhaseSummary s = {};
+        int n = count[p];
+        if (!n) return s;
+        float v[STATS_WINDOW];
+        memcpy(v, samples[p], n * sizeof(float));
+        std::sort(v, v + n);
+        auto at = [&](float q) { return v[min(n - 1, (int)(q * (n - 1) + 0.5f))]; };
+        s.p50 = at(0.50f);
+        s.p95 = at(0.95f);
+        s.p99 = at(0.99f);
+        s.min = v[0];
+        s.max = v[n - 1];
+        return s;
+    }
+};
+
+// ---- Quality governor (fullscreen): keeps the frame work inside the frame period by
+// stepping down a ladder of quality levels, fewer stars (a prefix of the field) first, then
+// coarser LOD tiers, then no pulse / whiten, and climbs back one level at a time once
+// there has been headroom for a while. Worker owned, fed by FrameScheduler's work average.
+static const int GOV_LEVELS = 8; // 0 = full quality
+static const int g_GovStarsPct[GOV_LEVELS + 1] = { 100, 85, 72, 60, 50, 42, 35, 28, 22 };
+static const int g_GovLodBoost[GOV_LEVELS + 1] = { 0, 0, 0, 1, 1, 1, 2, 2, 3 }; // added to both tiers
+static const int GOV_FX_LEVEL = 7;      // pulse and whiten off from this level
+static const double GOV_INTERVAL = 0.25; // seconds between decisions
+static const double GOV_OVER = 0.9;      // over budget: work above this share of the period
+static const double GOV_UNDER = 0.6;     // headroom: work below it
+static const int GOV_HOLD = 8;           // decisions with headroom before a level up
+static const int GOV_HOLD_MAX = 64;      // hold after repeated up / down flips
+
+struct QualityGovernor
+{
+    int level = 0;
+    int calm = 0;            // decisions in a row with headroom
+    int hold = GOV_HOLD;     // calm decisions needed to go up, doubles when a level up didn't last
+    int sinceUp = GOV_HOLD;  // decisions since the last level up
+    double next = 0.0;       // time of the next decision
+    float workMs = 0.0f;     // last decision's input, for the HUD
+    float periodMs = 0.0f;
+
+    int StarsPct() const { return g_GovStarsPct[level]; }
+    int LodBoost() const { return g_GovLodBoost[level]; }
+    bool Effects() const { return level < GOV_FX_LEVEL; }
+
+    void Reset()
+    {
+        *this = QualityGovernor();
+    }
+    // work and period in seconds, true when the level changed
+    bool Update(double work, double period, double now)
+    {
+        if (now < next) return false;
+        next = now + GOV_INTERVAL;
+        workMs = (float)(work * 1000.0);
+        periodMs = (float)(period * 1000.0);
+        ++sinceUp;
+        int old = level;
+        if (work > period * GOV_OVER)
+        {
+            calm = 0;
+            if (level == GOV_LEVELS) return false;
+            if (sinceUp <= GOV_HOLD) hold = min(GOV_HOLD_MAX, hold * 2); // the last level up was too much
+            level = min(GOV_LEVELS, level + (work > period * 1.5 ? 2 : 1));
+            next = now + 2 * GOV_INTERVAL; // let the work average settle on the new level
+        }
+        else if (work < period * GOV_UNDER)
+        {
+            if (level > 0 && ++calm >= hold)
+            {
+                --level;
+                calm = 0;
+                sinceUp = 0;
+                next = now + 2 * GOV_INTERVAL;
+            }
+            else if (sinceUp > GOV_HOLD_MAX && hold > GOV_HOLD) hold /= 2; // long stable stretch, relax
+        }
+        else calm = 0;
+        return level != old;
+    }
+};
+
+// ---- Draw list: visible stars ordered by bucket, then size (one counting sort).
+// Every renderer walks it, so dim (far) stars are drawn before bright (near) ones
+// and the GDI path selects each bucket brush once per frame.
+static const int DRAW_KEYS = BUCKETS * MAX_PSZ;
+
+struct DrawList
 {
-    float x;     // world X (centered)
-    float y;     // world Y (centered)
-    float z;     // depth
-    float speed; // per-star speed (depth units / second or arbitrary units)
+    AlignedBuffer<int> order;   // indices into rw->proj
+    int first[BUCKETS + 1] = {}; // order[first[b] .. first[b + 1]) is bucket b
 };
 
+static void BuildDrawList(const ProjectedStars& ps, DrawList& dl)
+{
+    int start[DRAW_KEYS + 1] = {};
+    dl.order.reserve(ps.count);
+    // histogram of bucket * MAX_PSZ + (psz - 1), prefix sums, scatter
+    for (int i = 0; i < ps.count; ++i) ++start[ps.bucket[i] * MAX_PSZ + ps.psz[i]];
+    for (int k = 1; k <= DRAW_KEYS; ++k) start[k] += start[k - 1];
+    for (int b = 0; b <= BUCKETS; ++b) dl.first[b] = start[b * MAX_PSZ];
+    for (int i = 0; i < ps.count; ++i) dl.order[start[ps.bucket[i] * MAX_PSZ + ps.psz[i] - 1]++] = i;
+}
+
 // RenderWindow
 struct RenderWindow
 {
@@ -66,30 +430,100 @@ struct RenderWindow
     HDC backHdc = NULL;
     HBITMAP backBmp = NULL;
     HBITMAP oldBackBmp = NULL;
+    uint32_t* bits = nullptr; // DIB section pixels (top-down 0x00RRGGBB), null on the GDI path
+    int bitsW = 0;      // frame size in use
+    int bitsH = 0;
+    int bitsStride = 0; // DIB row pitch in pixels (= backW)
+    int backW = 0;      // allocated bitmap size, a smaller frame reuses it
+    int backH = 0;
     RECT rc = {};
-    std::vector<Star> stars;
-    std::mt19937 rng;
+    StarSoA stars;
+    StarSoA* field = nullptr; // shared field (read-only) instead of stars, see SharedField
+    int fieldSpeed = 0;       // g_Speed the stars were spawned or last retimed for
+    CaptureRing* capture = nullptr; // /capture: this window's frames go to an encoder (worker owned)
+    ProjectedStars proj;
+    std::vector<int> chunkCounts; // visible stars per chunk in the parallel simulate
+    AlignedBuffer<int> respawnQueue; // simulate scratch: star indices to respawn, per chunk slice
+    DrawList drawList;               // rw->proj in draw order
+    StarRng rng;
     bool isPreview = false;
+    // monitor, filled in by MonEnumProc
+    int index = 0;
+    POINT desktopPos = {}; // top left in virtual desktop coordinates
+    UINT dpi = 96;
+    int refreshHz = 60;
+    bool primary = true;
+    std::thread worker; // fullscreen only: renders and presents this window
+    std::unique_ptr<StarRenderer> renderer;
+    // set by the UI thread, picked up by the worker at the start of its next frame
+    std::atomic<bool> active{ true };   // false: worker sleeps on wake (not showing, power suspended)
+    std::atomic<int> activeStars{ 0 };  // stars simulated and drawn, 0 = all (power throttling)
+    std::atomic<int> targetFps{ 0 };    // 0 = monitor refresh
+    std::atomic<int> starCount{ 0 };    // stars for this window's area, 0 = g_StarCount (hot reload)
+    std::atomic<bool> resized{ false }; // pendingRc holds a new client rect
+    std::mutex sizeMutex;
+    RECT pendingRc = {};
+    POINT pendingPos = {}; // and its monitor's top left, for the shared field slice
+    HANDLE wake = NULL;
+    std::atomic<bool> presented{ false }; // first frame is on screen, WM_ERASEBKGND stops painting black
+    FrameStats stats;      // frame / sim / draw / blit, written by whoever renders the window
+    int lodCounts[3] = {};  // last frame's stars per LOD tier: pixel, quad, sprite
+    QualityGovernor gov;    // fullscreen worker: level 0 (full quality) everywhere else
+    std::atomic<int> govLevel{ 0 }; // gov.level as the shared field's desktop pass sees it
+    int simulated = 0;      // stars in the last simulate pass, after power throttle and governor
+    char hudText[768] = {}; // refreshed by ReportStats
 };
 
 // Globals
 static HINSTANCE g_Hinst = NULL;
 static std::vector<RenderWindow*> g_Windows;
-static bool g_Running = true;
+static std::atomic<bool> g_Running{ true };
 
 // Input filtering
 static LARGE_INTEGER g_PerfFreq;
+static LARGE_INTEGER g_LaunchCounter; // wWinMain entry, for time to first frame
 static LARGE_INTEGER g_StartCounter;
 static double g_InputDebounceSeconds = 0.66; // mouse movement speed to stop screensaver from running
 static POINT g_StartMouse = { 0,0 };
-static bool g_StartMouseInit = false;
+static std::atomic<bool> g_StartMouseInit{ false }; // reset by WM_SIZE, read by the input thread
 static const int g_MouseMoveThreshold = 12; // pixels
 
+// Times a scope into one phase of a FrameStats
+struct ScopedTimer
+{
+    FrameStats& stats;
+    Phase phase;
+    LARGE_INTEGER start;
+    ScopedTimer(FrameStats& s, Phase p) : stats(s), phase(p) { QueryPerformanceCounter(&start); }
+    ~ScopedTimer()
+    {
+        LARGE_INTEGER now;
+        QueryPerformanceCounter(&now);
+        stats.Add(phase, (float)(double(now.QuadPart - start.QuadPart) * 1000.0 / double(g_PerfFreq.QuadPart)));
+    }
+};
+static FrameStats g_MainStats; // UI thread: message pump
+
+// Debug log line, visible in DebugView / the debugger output window
+static void LogLine(const char* fmt, ...)
+{
+    char buf[1024];
+    va_list args;
+    va_start(args, fmt);
+    vsprintf_s(buf, fmt, args);
+    va_end(args);
+    OutputDebugStringA(buf);
+    OutputDebugStringA("\n");
+}
+
+
 // Simple arg parsing
-static void ParseArgs(int argc, wchar_t** argv, wchar_t& modeOut, HWND& hwndOut)
+// "/mode:number" or "/mode number": the number is the preview parent hwnd for /p, the seed for /b,
+// the frame count for /v
+static void ParseArgs(int argc, wchar_t** argv, wchar_t& modeOut, unsigned long long& numOut)
 {
     modeOut = 0; 
-    hwndOut = NULL;
+    numOut = 0;
     if (argc <= 1) return;
     std::wstring a1 = argv[1];
     if (a1.size() >= 2 && (a1[0] == L'/' || a1[0] == L'-'))
@@ -99,208 +533,3253 @@ static void ParseArgs(int argc, wchar_t** argv, wchar_t& modeOut, HWND& hwndOut)
         size_t colon = a1.find(L':');
         if (colon != std::wstring::npos)
         {
-            std::wstring num = a1.substr(colon + 1);
-            if (!num.empty()) hwndOut = (HWND)_wcstoui64(num.c_str(), nullptr, 0);
+            std::wstring num = a1.substr(colon + 1);
+            if (!num.empty()) numOut = _wcstoui64(num.c_str(), nullptr, 0);
+        }
+        else if (argc >= 3)
+        {
+            std::wstring a2 = argv[2];
+            bool numeric = !a2.empty();
+            for (wchar_t ch : a2) if (!iswdigit(ch)) { numeric = false; break; }
+            if (numeric) numOut = _wcstoui64(a2.c_str(), nullptr, 0);
+        }
+    }
+}
+
+// Extra switches anywhere on the command line, e.g. "MyStarfield.scr /s /hud"
+static void ParseFlags(int argc, wchar_t** argv)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const wchar_t* a = argv[i];
+        if (a[0] != L'/' && a[0] != L'-') continue;
+        if (_wcsicmp(a + 1, L"hud") == 0) g_ShowHud = true;
+        else if (_wcsicmp(a + 1, L"png") == 0) g_CapturePng = true;
+        else if (_wcsicmp(a + 1, L"capture") == 0) g_CaptureLive = true;
+    }
+}
+
+// ---- GDI backbuffer helpers (GDI and DIB renderers)
+// A frame that fits the current bitmap keeps it (mode switches, RDP reconnects), the
+// renderers only ever touch and present the bitsW x bitsH corner.
+static bool CreateGdiBackbuffer(RenderWindow* rw, bool dib)
+{
+    if (!rw) return false;
+    int w = max(1, rw->rc.right - rw->rc.left);
+    int h = max(1, rw->rc.bottom - rw->rc.top);
+    if (rw->backHdc && w <= rw->backW && h <= rw->backH && (rw->bits != nullptr) == dib)
+    {
+        rw->bitsW = w;
+        rw->bitsH = h;
+        if (dib)
+        {
+            GdiFlush();
+            memset(rw->bits, 0, (size_t)rw->bitsStride * rw->backH * sizeof(uint32_t));
+        }
+        else
+        {
+            RECT rc = { 0,0,rw->backW,rw->backH };
+            FillRect(rw->backHdc, &rc, (HBRUSH)GetStockObject(BLACK_BRUSH));
+        }
+        return true;
+    }
+    // no window (benchmark): the screen DC is the reference
+    HDC wnd = GetDC(rw->hwnd);
+    if (!wnd) return false;
+    // release existing
+    if (rw->backHdc)
+    {
+        SelectObject(rw->backHdc, rw->oldBackBmp);
+        DeleteObject(rw->backBmp);
+        DeleteDC(rw->backHdc);
+        rw->backHdc = NULL; 
+        rw->backBmp = NULL; 
+        rw->oldBackBmp = NULL;
+        rw->bits = nullptr;
+    }
+    HDC mem = CreateCompatibleDC(wnd);
+    HBITMAP bmp = NULL;
+    void* bits = nullptr;
+    if (dib)
+    {
+        // 32bpp top-down section so row y starts at bits + y * w
+        BITMAPINFO bmi = {};
+        bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+        bmi.bmiHeader.biWidth = w;
+        bmi.bmiHeader.biHeight = -h;
+        bmi.bmiHeader.biPlanes = 1;
+        bmi.bmiHeader.biBitCount = 32;
+        bmi.bmiHeader.biCompression = BI_RGB;
+        bmp = CreateDIBSection(wnd, &bmi, DIB_RGB_COLORS, &bits, NULL, 0);
+        if (!bits && bmp) { DeleteObject(bmp); bmp = NULL; }
+    }
+    else
+    {
+        bmp = CreateCompatibleBitmap(wnd, w, h);
+    }
+    if (!mem || !bmp)
+    {
+        if (mem) DeleteDC(mem);
+        if (bmp) DeleteObject(bmp);
+        ReleaseDC(rw->hwnd, wnd);
+        return false;
+    }
+    rw->oldBackBmp = (HBITMAP)SelectObject(mem, bmp);
+    rw->backHdc = mem;
+    rw->backBmp = bmp;
+    rw->bits = (uint32_t*)bits;
+    rw->bitsW = w;
+    rw->bitsH = h;
+    rw->bitsStride = w;
+    rw->backW = w;
+    rw->backH = h;
+    // init black background, a fresh DIB section already is
+    if (!dib)
+    {
+        HBRUSH b = (HBRUSH)GetStockObject(BLACK_BRUSH);
+        RECT rc = { 0,0,w,h };
+        FillRect(rw->backHdc, &rc, b);
+    }
+    ReleaseDC(rw->hwnd, wnd);
+    return true;
+}
+
+static void DestroyGdiBackbuffer(RenderWindow* rw)
+{
+    if (!rw) return;
+    if (rw->backHdc)
+    {
+        SelectObject(rw->backHdc, rw->oldBackBmp);
+        DeleteObject(rw->backBmp);
+        DeleteDC(rw->backHdc);
+        rw->backHdc = NULL; 
+        rw->backBmp = NULL; 
+        rw->oldBackBmp = NULL;
+        rw->bits = nullptr;
+        rw->bitsW = 0;
+        rw->bitsH = 0;
+        rw->bitsStride = 0;
+        rw->backW = 0;
+        rw->backH = 0;
+    }
+}
+
+// InitStars: centered world coords (so projection works predictably)
+// Smaller Z_MIN(closer to 0) makes stars appear larger and move faster
+// as they approach because projection uses 1 / z.
+static constexpr float Z_MIN = 1.0f;
+// decrease Z_MAX (e.g., 800) to bring more stars visually forward
+static constexpr float Z_MAX = 33.0f;
+static constexpr float Z_RANGE = Z_MAX - Z_MIN;
+static constexpr float Z_QSTEP = Z_RANGE / 65536.0f; // compact depth step
+// FOCAL ~ 1.0 is appropriate for the sample values (x ~ [-1600..1600], z ~ [10..100])
+static constexpr float FOCAL = 9.0f;
+// multiplier that controls drawn core size; increase for larger stars
+static constexpr float SIZE_SCALE = 1.0f;
+
+// Star color for a bucket, from the intensity (0..255) of a star in it
+static COLORREF BucketColor(int bucket, int intensity, bool whitenNear = true)
+{
+    int baseR = GetRValue(g_Color), baseG = GetGValue(g_Color), baseB = GetBValue(g_Color);
+    int br = (baseR * intensity) / 255;
+    int bg = (baseG * intensity) / 255;
+    int bb = (baseB * intensity) / 255;
+    if (!whitenNear) return RGB(br, bg, bb);
+    // slightly move nearer buckets toward white for pop
+    float whiten = 0.5f + 0.5f * (bucket / (float)(BUCKETS - 1));
+    br = min(255, (int)lroundf(br * whiten + 255 * (1.0f - whiten)));
+    bg = min(255, (int)lroundf(bg * whiten + 255 * (1.0f - whiten)));
+    bb = min(255, (int)lroundf(bb * whiten + 255 * (1.0f - whiten)));
+    return RGB(br, bg, bb);
+}
+
+// ---- GDI path: precomputed disc outlines
+// g_DiscSpans[r] holds the half-width of each of the 2r+1 rows of a disc of radius r,
+// g_DiscOutlines[r] is that disc as a staircase polygon around its pixels, for
+// PolyPolygon (which leaves out the right and bottom edge) instead of Ellipse.
+static std::vector<uint8_t> g_DiscSpans[MAX_PSZ + 1];
+static std::vector<POINT> g_DiscOutlines[MAX_PSZ + 1];
+
+static void BuildDiscOutline(int r)
+{
+    const std::vector<uint8_t>& spans = g_DiscSpans[r];
+    std::vector<POINT> pts;
+    // right side downwards, left side upwards: two corners per row
+    for (int k = 0; k <= 2 * r; ++k)
+    {
+        LONG x = spans[k] + 1;
+        pts.push_back({ x, k - r });
+        pts.push_back({ x, k - r + 1 });
+    }
+    for (int k = 2 * r; k >= 0; --k)
+    {
+        LONG x = -(LONG)spans[k];
+        pts.push_back({ x, k - r + 1 });
+        pts.push_back({ x, k - r });
+    }
+    // drop corners where the outline runs straight on
+    std::vector<POINT>& out = g_DiscOutlines[r];
+    size_t n = pts.size();
+    for (size_t i = 0; i < n; ++i)
+    {
+        const POINT& a = pts[(i + n - 1) % n];
+        const POINT& b = pts[i];
+        const POINT& c = pts[(i + 1) % n];
+        bool straight = (a.x == b.x && b.x == c.x) || (a.y == b.y && b.y == c.y);
+        if (!straight) out.push_back(b);
+    }
+}
+
+static void BuildDiscSprites()
+{
+    if (!g_DiscSpans[1].empty()) return;
+    for (int r = 1; r <= MAX_PSZ; ++r)
+    {
+        g_DiscSpans[r].resize(2 * r + 1);
+        float rr = (r + 0.5f) * (r + 0.5f);
+        for (int dy = -r; dy <= r; ++dy)
+            g_DiscSpans[r][dy + r] = (uint8_t)sqrtf(rr - (float)(dy * dy));
+        BuildDiscOutline(r);
+    }
+}
+
+// COLORREF (0x00BBGGRR) -> DIB pixel (0x00RRGGBB)
+static inline uint32_t DibColor(COLORREF c)
+{
+    return ((uint32_t)GetRValue(c) << 16) | ((uint32_t)GetGValue(c) << 8) | (uint32_t)GetBValue(c);
+}
+
+// ---- Glow sprites (DIB and D3D11): one 8-bit alpha sprite per radius r, a solid
+// anti-aliased core of radius r with a halo out to GlowExtent(r), (2e+1)^2 bytes.
+// A bucket only scales the color, so the (size, bucket) pair is the size's sprite
+// read through the bucket's premultiplied color table. Built on first use: the big
+// radii add up to megabytes and are rarely drawn.
+static inline int GlowExtent(int r) { return r + r / 2 + 1; }
+static std::vector<uint8_t> g_GlowSprites[MAX_PSZ + 1];
+static std::once_flag g_GlowOnce[MAX_PSZ + 1];
+
+static void BuildGlowSprite(int r)
+{
+    int e = GlowExtent(r), size = 2 * e + 1;
+    std::vector<uint8_t>& sprite = g_GlowSprites[r];
+    sprite.resize((size_t)size * size);
+    float halo = (float)(e - r) + 0.5f;
+    for (int dy = -e; dy <= e; ++dy)
+    {
+        for (int dx = -e; dx <= e; ++dx)
+        {
+            float d = sqrtf((float)(dx * dx + dy * dy));
+            // core coverage with a one pixel edge, halo falls off quadratically to 0
+            float core = max(0.0f, min(1.0f, r + 0.5f - d));
+            float t = max(0.0f, 1.0f - (d - r) / halo);
+            float a = max(core, 0.35f * t * t);
+            sprite[(size_t)(dy + e) * size + dx + e] = (uint8_t)lroundf(a * 255.0f);
+        }
+    }
+}
+
+static const uint8_t* GlowSprite(int r)
+{
+    std::call_once(g_GlowOnce[r], BuildGlowSprite, r);
+    return g_GlowSprites[r].data();
+}
+
+// table[a] = color * a / 255 per channel, as a DIB pixel
+static void BuildGlowColors(COLORREF c, uint32_t table[256])
+{
+    for (int a = 0; a < 256; ++a)
+    {
+        int r = (GetRValue(c) * a + 127) / 255, g = (GetGValue(c) * a + 127) / 255, b = (GetBValue(c) * a + 127) / 255;
+        table[a] = DibColor(RGB(r, g, b));
+    }
+}
+
+// Per byte saturating a + b
+static inline uint32_t AddSaturate(uint32_t a, uint32_t b)
+{
+    const uint32_t high = 0x80808080u;
+    uint32_t t0 = (a ^ b) & high;
+    uint32_t t1 = a & b & high;
+    uint32_t s = (a & ~high) + (b & ~high);
+    t1 |= t0 & s;                      // carry out of each byte
+    t1 = (t1 << 1) - (t1 >> 7);        // 0xFF where a byte overflowed
+    return (s ^ t0) | t1;
+}
+
+// Additive glow of radius r centered on (cx, cy), clipped to the DIB
+static void BlendGlow(RenderWindow* rw, int cx, int cy, int r, const uint32_t table[256])
+{
+    int e = GlowExtent(r), size = 2 * e + 1;
+    const uint8_t* sprite = GlowSprite(r);
+    int x0 = max(0, cx - e), x1 = min(rw->bitsW - 1, cx + e);
+    int y0 = max(0, cy - e), y1 = min(rw->bitsH - 1, cy + e);
+    for (int y = y0; y <= y1; ++y)
+    {
+        const uint8_t* src = sprite + (size_t)(y - cy + e) * size + (x0 - cx + e);
+        uint32_t* row = rw->bits + (size_t)y * rw->bitsStride;
+        for (int x = x0; x <= x1; ++x) row[x] = AddSaturate(row[x], table[src[x - x0]]);
+    }
+}
+
+// Respawn constants, computed once per frame
+struct SpawnParams
+{
+    float spanX, spanY; // 2x the viewport
+    float speed;        // g_Speed as of this frame
+    float jitter;       // speed jitter range, whole steps in [0, jitter)
+    float coneX, coneY; // recycling: spawn only inside |x| <= coneX * z (0 = whole span)
+};
+
+// speed: g_Speed loaded once by the caller, the base the field was spawned or retimed for
+static SpawnParams MakeSpawnParams(int width, int height, int speed)
+{
+    SpawnParams sp;
+    sp.spanX = (float)width * 2.0f;
+    sp.spanY = (float)height * 2.0f;
+    sp.speed = (float)speed;
+    sp.jitter = (float)max(1, speed / 2 + 1);
+    // half view plus the largest star, over the focal length: the kernels' frustum test
+    sp.coneX = g_RecycleOffscreen ? (width * 0.5f + MAX_PSZ) / FOCAL : 0.0f;
+    sp.coneY = g_RecycleOffscreen ? (height * 0.5f + MAX_PSZ) / FOCAL : 0.0f;
+    return sp;
+}
+
+// Respawn star i at a random position across 2x the viewport (or the view cone), anywhere in depth
+static inline void RespawnStar(StarSoA& st, StarRng& rng, int i, const SpawnParams& sp)
+{
+    float fx = rng.Next01();
+    float fy = rng.Next01();
+    float fz = rng.Next01();
+    float fs = rng.Next01();
+
+    // deep range (classic)
+    float z = fz * (Z_MAX - Z_MIN) + Z_MIN;
+
+    // centered world coords as in your samples; with recycling, only where it can be seen
+    float halfX = sp.spanX * 0.5f, halfY = sp.spanY * 0.5f;
+    if (sp.coneX > 0.0f) halfX = min(halfX, sp.coneX * z);
+    if (sp.coneY > 0.0f) halfY = min(halfY, sp.coneY * z);
+    float x = (fx - 0.5f) * 2.0f * halfX;
+    float y = (fy - 0.5f) * 2.0f * halfY;
+    int jitter = (int)(fs * sp.jitter);
+    if (st.compact)
+    {
+        st.qx[i] = (int16_t)max(-32767, min(32767, (int)lroundf(x / st.qScaleX)));
+        st.qy[i] = (int16_t)max(-32767, min(32767, (int)lroundf(y / st.qScaleY)));
+        st.qz[i] = (uint16_t)min(65535, (int)lroundf(fz * 65536.0f));
+        st.qspeed[i] = (uint8_t)min(255, jitter);
+        return;
+    }
+    st.z[i] = z;
+    st.x[i] = x;
+    st.y[i] = y;
+    st.speed[i] = sp.speed + (float)jitter;
+}
+
+// Compact stars cover the spawn span in Q15 steps, speeds count up from g_Speed
+static void SetCompactScale(StarSoA& st, const SpawnParams& sp)
+{
+    st.qScaleX = sp.spanX * 0.5f / 32767.0f;
+    st.qScaleY = sp.spanY * 0.5f / 32767.0f;
+    st.qSpeed0 = sp.speed;
+}
+
+// StarCount is the field of a 1920x1080 screen, other sizes keep its density per megapixel
+static const double STAR_REF_PIXELS = 1920.0 * 1080.0;
+static int StarsForArea(int w, int h)
+{
+    double n = g_StarCount * ((double)max(1, w) * max(1, h) / STAR_REF_PIXELS);
+    return (int)min((double)g_MaxStars, max(1.0, n));
+}
+
+// The field spans 2x the window in world X/Y, a resize stretches it in place
+// instead of respawning everything
+static void RescaleStars(StarSoA& st, int oldW, int oldH, int newW, int newH)
+{
+    if (oldW <= 0 || oldH <= 0 || (oldW == newW && oldH == newH)) return;
+    float sx = (float)newW / (float)oldW;
+    float sy = (float)newH / (float)oldH;
+    if (st.compact)
+    {
+        // positions are fractions of the span, only the step changes
+        st.qScaleX *= sx;
+        st.qScaleY *= sy;
+        return;
+    }
+    float* x = st.x.data;
+    float* y = st.y.data;
+    for (int i = 0; i < st.count; ++i)
+    {
+        x[i] *= sx;
+        y[i] *= sy;
+    }
+}
+
+// ---- Shared field (SharedField = 1): one star field for the whole virtual desktop,
+// vanishing point at its center. It runs analytic, so the stars are only ever read.
+// Each frame the field is projected once, in desktop coordinates, by whichever worker
+// needs it first, and cut into per-monitor slices there; the other workers copy their
+// slice out of that frame (SimulateShared).
+static const int SHARED_FRAMES = 3; // latest, one being written, one still being copied from
+
+struct SharedFrame
+{
+    ProjectedStars desktop;                  // visible anywhere on the desktop
+    std::unique_ptr<ProjectedStars[]> views; // per window (rw->index), window coordinates
+    double time = -1.0;
+    int simulated = 0;                       // field prefix the pass covered
+    int readers = 0;                         // workers copying their slice
+};
+
+struct SharedSlice
+{
+    float ox, oy; // window's top left in desktop coordinates
+    float w, h;
+    UINT dpi;
+};
+
+struct SharedField
+{
+    StarSoA stars;
+    RECT rc = {};       // union of the monitors
+    int count = 0;      // sum of the monitors' star counts, capped at g_MaxStars
+    int speed = 0;      // g_Speed at InitSharedField, kept until restart
+    UINT dpi = 96;      // largest monitor DPI, the desktop pass sizes stars for it
+    std::vector<SharedSlice> slices; // per window, updated on resize under frameMutex
+    std::once_flag once;
+    // projection, guarded by frameMutex except for the frame being written
+    SharedFrame frames[SHARED_FRAMES];
+    int latest = -1;
+    bool writing = false;
+    std::mutex frameMutex;
+    std::condition_variable frameCv;
+    // desktop pass scratch, only touched by the writer
+    std::vector<SharedSlice> passSlices; // slices as of the pass
+    AlignedBuffer<int> respawnQueue;
+    std::vector<int> chunkCounts;
+    StarRng rng;
+};
+static SharedField g_Shared;
+
+static void InitSharedField()
+{
+    int w = max(1, g_Shared.rc.right - g_Shared.rc.left);
+    int h = max(1, g_Shared.rc.bottom - g_Shared.rc.top);
+    int count = g_Shared.count;
+    StarRng rng;
+    std::random_device rd;
+    rng.Seed(((uint64_t)rd() << 32) | rd());
+    g_Shared.speed = g_Speed;
+    SpawnParams sp = MakeSpawnParams(w, h, g_Shared.speed);
+    g_Shared.stars.compact = g_Compact;
+    SetCompactScale(g_Shared.stars, sp);
+    g_Shared.stars.resize(count);
+    for (int i = 0; i < count; ++i) RespawnStar(g_Shared.stars, rng, i, sp);
+}
+
+static void InitStars(RenderWindow* rw)
+{
+    if (!rw) return;
+    RECT r = rw->rc;
+    int width = max(1, r.right - r.left);
+    int height = max(1, r.bottom - r.top);
+    int count = rw->starCount;
+    if (count <= 0) count = g_StarCount;
+    SpawnParams sp = MakeSpawnParams(width, height, g_Speed);
+    rw->stars.clear();
+    rw->stars.compact = g_Compact;
+    SetCompactScale(rw->stars, sp);
+    rw->stars.resize(count);
+    rw->proj.reserve(count);
+    for (int i = 0; i < count; ++i) RespawnStar(rw->stars, rw->rng, i, sp);
+    rw->fieldSpeed = (int)sp.speed;
+}
+
+// Hot reload: move every star's speed from the old jitter range to the new one, whole
+// numbers as the analytic phase needs. Analytic stars get their spawn depth shifted by
+// the speed change times the frame's phase, so nobody jumps in depth.
+static void RetimeStars(StarSoA& st, int oldSpeed, int newSpeed, double totalTime)
+{
+    float oldJitter = (float)max(1, oldSpeed / 2 + 1), newJitter = (float)max(1, newSpeed / 2 + 1);
+    float k = newJitter / oldJitter;
+    float phase = (float)fmod(totalTime * 0.5, (double)Z_RANGE);
+    for (int i = 0; i < st.count; ++i)
+    {
+        float s = st.compact ? st.qSpeed0 + (float)st.qspeed[i] : st.speed[i];
+        int step = max(0, (int)lroundf((s - (float)oldSpeed) * k));
+        float s2 = (float)(newSpeed + step);
+        if (st.compact) st.qspeed[i] = (uint8_t)min(255, step);
+        else st.speed[i] = s2;
+        if (!g_Analytic) continue; // stepped stars carry their current depth
+        float zOff = st.compact ? (float)st.qz[i] * Z_QSTEP : st.z[i] - Z_MIN;
+        zOff += (s2 - s) * phase;
+        zOff -= Z_RANGE * floorf(zOff * (1.0f / Z_RANGE));
+        if (st.compact) st.qz[i] = (uint16_t)min(65535, (int)lroundf(zOff / Z_QSTEP));
+        else st.z[i] = Z_MIN + zOff;
+    }
+    st.qSpeed0 = (float)newSpeed;
+}
+
+// Hot reload, on the worker before a frame: new g_Speed and star count applied to the
+// window's own field in place, growing or shrinking it at the tail. The shared field is
+// read by every worker without locking, it only changes on restart.
+static void UpdateField(RenderWindow* rw, double totalTime)
+{
+    if (rw->field) return;
+    StarSoA& st = rw->stars;
+    int speed = g_Speed;
+    if (speed != rw->fieldSpeed)
+    {
+        RetimeStars(st, rw->fieldSpeed, speed, totalTime);
+        rw->fieldSpeed = speed;
+    }
+    int count = rw->starCount, old = st.count;
+    if (count <= 0 || count == old) return;
+    st.resize(count);
+    SpawnParams sp = MakeSpawnParams(max(1, rw->rc.right - rw->rc.left), max(1, rw->rc.bottom - rw->rc.top), speed);
+    for (int i = old; i < count; ++i) RespawnStar(st, rw->rng, i, sp);
+}
+
+// ---- Simulate pass: advance, respawn, project, classify, cull
+// Kernel profiles: compile-time constants each kernel variant is instantiated with,
+// so the size factor, clamps and bucket scale fold into immediates.
+enum SimProfile { PROFILE_FULLSCREEN = 0, PROFILE_PREVIEW = 1, PROFILE_COUNT };
+
+struct FullscreenProfile
+{
+    static constexpr float sizeK = SIZE_SCALE * Z_MIN / FOCAL; // psz = sizeK * FOCAL / z
+    static constexpr int maxPsz = MAX_PSZ;
+    static constexpr float bucketK = BUCKETS / 256.0f;
+};
+
+// the preview thumbnail is ~150 px wide, nothing there needs a 128 px star
+struct PreviewProfile : FullscreenProfile
+{
+    static constexpr int maxPsz = 12;
+};
+
+// Per-frame constants for the kernels, everything loop invariant is folded here
+struct SimParams
+{
+    float zStep;     // depth advance per unit of speed (dt * 0.5)
+    float cx, cy;    // projection center
+    float w, h;      // viewport for the offscreen test
+    float i0, i1;    // intensity = i0 + i1 * z (depth falloff with pulse folded in)
+    float sizeScale; // monitor DPI / 96, multiplies Cfg::sizeK
+    int recycle;     // 1: stars outside the view cone are respawned, not just skipped
+    int analytic;    // 1: z = Z_MIN + (z0 - Z_MIN - speed * zPhase) mod range, nothing is written
+    int streak;      // 1: also project the tail (depth one frame earlier) of visible stars
+    float zPhase;    // analytic: (totalTime * 0.5) mod range
+    SpawnParams spawn;
+    SimProfile profile;
+};
+
+// speed: the base speed of the field being simulated (rw->fieldSpeed), not a fresh g_Speed
+static SimParams MakeSimParams(int w, int h, float dt, double totalTime, int speed, SimProfile profile = PROFILE_FULLSCREEN, float sizeScale = 1.0f,
+    bool pulsing = true)
+{
+    // subtle pulse
+    float pulse = pulsing ? 1.0f + 0.05f * sinf((float)totalTime * 1.5f) : 1.0f;
+    // intensity = 100 + (1 - (z - Z_MIN) / (Z_MAX - Z_MIN)) * 155 * pulse
+    float k = 155.0f * pulse / (Z_MAX - Z_MIN);
+    SimParams p;
+    p.zStep = dt * 0.5f;
+    p.cx = w * 0.5f;
+    p.cy = h * 0.5f;
+    p.w = (float)w;
+    p.h = (float)h;
+    p.i0 = 100.0f + 155.0f * pulse + k * Z_MIN;
+    p.i1 = -k;
+    p.sizeScale = sizeScale;
+    p.analytic = g_Analytic ? 1 : 0;
+    p.streak = g_Streaks ? 1 : 0;
+    p.recycle = (g_RecycleOffscreen && !g_Analytic) ? 1 : 0; // analytic stars are never rewritten
+    // speeds are whole numbers, so speed * (t mod range) == speed * t (mod range) and the
+    // phase stays small enough for float however long the saver runs
+    p.zPhase = (float)fmod(totalTime * 0.5, (double)Z_RANGE);
+    p.spawn = MakeSpawnParams(w, h, speed);
+    p.profile = profile;
+    return p;
+}
+
+enum SimdLevel { SIMD_NONE = 0, SIMD_SSE2 = 1, SIMD_AVX2 = 2 };
+static SimdLevel g_Simd = SIMD_NONE;
+
+static SimdLevel DetectSimd()
+{
+    int info[4] = {};
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    bool sse2 = (info[3] & (1 << 26)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    bool avx2 = false;
+    // AVX2 also needs the OS to save YMM state
+    if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 6) == 6)
+    {
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0;
+    }
+    return avx2 ? SIMD_AVX2 : (sse2 ? SIMD_SSE2 : SIMD_NONE);
+}
+
+// Refill StarRng::buf, 24 random bits per float
+void StarRng::Fill()
+{
+    const float scale = 1.0f / 16777216.0f;
+    if (g_Simd >= SIMD_SSE2)
+    {
+        __m128i s0 = _mm_loadu_si128((const __m128i*)s[0]);
+        __m128i s1 = _mm_loadu_si128((const __m128i*)s[1]);
+        __m128i s2 = _mm_loadu_si128((const __m128i*)s[2]);
+        __m128i s3 = _mm_loadu_si128((const __m128i*)s[3]);
+        const __m128 vscale = _mm_set1_ps(scale);
+        for (int i = 0; i < RNG_BUF; i += 4)
+        {
+            __m128i r = _mm_add_epi32(s0, s3);
+            _mm_storeu_ps(buf + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(r, 8)), vscale));
+            __m128i t = _mm_slli_epi32(s1, 9);
+            s2 = _mm_xor_si128(s2, s0);
+            s3 = _mm_xor_si128(s3, s1);
+            s1 = _mm_xor_si128(s1, s2);
+            s0 = _mm_xor_si128(s0, s3);
+            s2 = _mm_xor_si128(s2, t);
+            s3 = _mm_or_si128(_mm_slli_epi32(s3, 11), _mm_srli_epi32(s3, 21));
+        }
+        _mm_storeu_si128((__m128i*)s[0], s0);
+        _mm_storeu_si128((__m128i*)s[1], s1);
+        _mm_storeu_si128((__m128i*)s[2], s2);
+        _mm_storeu_si128((__m128i*)s[3], s3);
+    }
+    else
+    {
+        for (int i = 0; i < RNG_BUF; i += 4)
+        {
+            for (int l = 0; l < 4; ++l)
+            {
+                uint32_t r = s[0][l] + s[3][l];
+                buf[i + l] = (float)(r >> 8) * scale;
+                uint32_t t = s[1][l] << 9;
+                s[2][l] ^= s[0][l];
+                s[3][l] ^= s[1][l];
+                s[1][l] ^= s[2][l];
+                s[0][l] ^= s[3][l];
+                s[2][l] ^= t;
+                s[3][l] = (s[3][l] << 11) | (s[3][l] >> 21);
+            }
+        }
+    }
+    pos = 0;
+}
+
+// Kernels simulate stars [begin, end) and append visible ones to out starting at n,
+// returning the new n. Stars that passed Z_MIN are not projected, their indices are
+// appended to dead[nd] without branching and respawned afterwards in one batch.
+// Before any projection math a conservative frustum test, x * FOCAL outside
+// [-(cx + maxPsz) * z, (w - cx + maxPsz) * z] (same for y), drops stars that can't touch
+// the view; cx is off center for a slice of the shared field. x and y are fixed and z only shrinks, so such a
+// star never comes back: with p.recycle it joins the respawn queue instead.
+// Analytic kernels derive z from the spawn depth in st.z and the frame's phase instead of
+// stepping it, wrap by modulo over the depth range and never respawn: st is read-only.
+// Compact kernels are analytic ones reading the packed layout.
+
+// Star i in either layout: world x / y, depth above Z_MIN and speed. The SIMD unpacks do
+// the same float ops, int to float then one multiply or add.
+template <bool Compact> static inline float StarX(const StarSoA& st, int i) { return Compact ? (float)st.qx[i] * st.qScaleX : st.x[i]; }
+template <bool Compact> static inline float StarY(const StarSoA& st, int i) { return Compact ? (float)st.qy[i] * st.qScaleY : st.y[i]; }
+template <bool Compact> static inline float StarZOff(const StarSoA& st, int i) { return Compact ? (float)st.qz[i] * Z_QSTEP : st.z[i] - Z_MIN; }
+template <bool Compact> static inline float StarSpeed(const StarSoA& st, int i) { return Compact ? st.qSpeed0 + (float)st.qspeed[i] : st.speed[i]; }
+
+// Streaks: visible star i at depth z one frame ago, further out so nearer the center.
+// Only visible stars get here; all kernels share it so their output stays identical.
+template <bool Compact>
+static inline void ProjectTail(const StarSoA& st, ProjectedStars& out, const SimParams& p, int i, float z, int n)
+{
+    float f = FOCAL / (z + StarSpeed<Compact>(st, i) * p.zStep);
+    out.tx[n] = p.cx + StarX<Compact>(st, i) * f;
+    out.ty[n] = p.cy + StarY<Compact>(st, i) * f;
+}
+
+// Scalar reference kernel, also handles the tail that does not fill 8 lanes
+template <typename Cfg, bool Analytic, bool Compact>
+static int SimulateScalar(StarSoA& st, ProjectedStars& out, int* dead, int& nd, const SimParams& p, int begin, int end, int n)
+{
+    for (int i = begin; i < end; ++i)
+    {
+        float x = StarX<Compact>(st, i), y = StarY<Compact>(st, i), speed = StarSpeed<Compact>(st, i);
+        float z;
+        if (Analytic)
+        {
+            float u = StarZOff<Compact>(st, i) - speed * p.zPhase;
+            z = Z_MIN + (u - Z_RANGE * floorf(u * (1.0f / Z_RANGE)));
+        }
+        else
+        {
+            // advance depth
+            st.z[i] -= speed * p.zStep;
+            z = st.z[i];
+        }
+        float xf = x * FOCAL, yf = y * FOCAL;
+        int outside = (xf < -(p.cx + Cfg::maxPsz) * z) | (xf > (p.w - p.cx + Cfg::maxPsz) * z) |
+            (yf < -(p.cy + Cfg::maxPsz) * z) | (yf > (p.h - p.cy + Cfg::maxPsz) * z);
+        // queue for respawn
+        int gone = Analytic ? 0 : (z <= Z_MIN) | (outside & p.recycle);
+        dead[nd] = i;
+        nd += gone;
+        if (gone | outside) continue;
+
+        // projection using small focal factor
+        float f = FOCAL / z;
+        float px = p.cx + x * f;
+        float py = p.cy + y * f;
+
+        // size scales with inverse depth; near -> larger
+        int psz = (int)ceilf(max(1.0f, Cfg::sizeK * p.sizeScale * f));
+        if (psz > Cfg::maxPsz) psz = Cfg::maxPsz;
+
+        // skip if offscreen
+        if (px + psz < 0 || px - psz > p.w || py + psz < 0 || py - psz > p.h) continue;
+
+        // intensity from depth (near -> brighter), pulse already folded in; ties round to
+        // even like _mm_cvtps_epi32 / _mm256_round_ps, so all kernels pick the same bucket
+        int intensity = (int)nearbyintf(p.i0 + p.i1 * z);
+        intensity = max(0, min(255, intensity));
+        int bucket = (int)(intensity * Cfg::bucketK);
+
+        out.px[n] = px;
+        out.py[n] = py;
+        out.psz[n] = (uint8_t)psz;
+        out.bucket[n] = (uint8_t)bucket;
+        if (p.streak) ProjectTail<Compact>(st, out, p, i, z, n);
+        ++n;
+    }
+    return n;
+}
+
+// Compact stars i..i+3: sign / zero extend to 32 bits, then the same ops as StarX & co.,
+// z comes back as the depth above Z_MIN
+static inline void UnpackSSE2(const StarSoA& st, int i, __m128& x, __m128& y, __m128& z, __m128& speed)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i qx = _mm_loadl_epi64((const __m128i*)(st.qx.data + i));
+    __m128i qy = _mm_loadl_epi64((const __m128i*)(st.qy.data + i));
+    __m128i qz = _mm_loadl_epi64((const __m128i*)(st.qz.data + i));
+    __m128i qs = _mm_cvtsi32_si128(*(const int*)(st.qspeed.data + i));
+    x = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(qx, qx), 16)), _mm_set1_ps(st.qScaleX));
+    y = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(qy, qy), 16)), _mm_set1_ps(st.qScaleY));
+    z = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(qz, zero)), _mm_set1_ps(Z_QSTEP));
+    speed = _mm_add_ps(_mm_set1_ps(st.qSpeed0), _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(qs, zero), zero)));
+}
+
+// SSE2 kernel: 4 lanes, called twice per 8-star iteration
+template <typename Cfg, bool Analytic, bool Compact>
+static inline int SimulateSSE2Lanes(StarSoA& st, ProjectedStars& out, int* dead, int& nd, const SimParams& p, int i, int n)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    __m128 x, y, z, speed;
+    if (Compact) UnpackSSE2(st, i, x, y, z, speed);
+    else
+    {
+        x = _mm_load_ps(st.x.data + i);
+        y = _mm_load_ps(st.y.data + i);
+        z = _mm_load_ps(st.z.data + i);
+        speed = _mm_load_ps(st.speed.data + i);
+    }
+    __m128 alive;
+    if (Analytic)
+    {
+        // floor by truncate and step down, u / range stays far inside int range
+        __m128 zOff = Compact ? z : _mm_sub_ps(z, _mm_set1_ps(Z_MIN));
+        __m128 u = _mm_sub_ps(zOff, _mm_mul_ps(speed, _mm_set1_ps(p.zPhase)));
+        __m128 q = _mm_mul_ps(u, _mm_set1_ps(1.0f / Z_RANGE));
+        __m128 fq = _mm_cvtepi32_ps(_mm_cvttps_epi32(q));
+        fq = _mm_sub_ps(fq, _mm_and_ps(_mm_cmpgt_ps(fq, q), one));
+        z = _mm_add_ps(_mm_set1_ps(Z_MIN), _mm_sub_ps(u, _mm_mul_ps(_mm_set1_ps(Z_RANGE), fq)));
+        alive = _mm_castsi128_ps(_mm_set1_epi32(-1));
+    }
+    else
+    {
+        z = _mm_sub_ps(z, _mm_mul_ps(speed, _mm_set1_ps(p.zStep)));
+        _mm_store_ps(st.z.data + i, z);
+        alive = _mm_cmpgt_ps(z, _mm_set1_ps(Z_MIN));
+    }
+    const __m128 focal = _mm_set1_ps(FOCAL);
+    __m128 xf = _mm_mul_ps(x, focal), yf = _mm_mul_ps(y, focal);
+    __m128 inside = _mm_and_ps(
+        _mm_and_ps(_mm_cmpge_ps(xf, _mm_mul_ps(_mm_set1_ps(-(p.cx + Cfg::maxPsz)), z)), _mm_cmple_ps(xf, _mm_mul_ps(_mm_set1_ps(p.w - p.cx + Cfg::maxPsz), z))),
+        _mm_and_ps(_mm_cmpge_ps(yf, _mm_mul_ps(_mm_set1_ps(-(p.cy + Cfg::maxPsz)), z)), _mm_cmple_ps(yf, _mm_mul_ps(_mm_set1_ps(p.h - p.cy + Cfg::maxPsz), z))));
+    int aliveMask = _mm_movemask_ps(alive);
+    int insideMask = _mm_movemask_ps(inside);
+    int respawn = (~aliveMask | (~insideMask & -p.recycle)) & 15;
+    for (int b = 0; b < 4; ++b)
+    {
+        dead[nd] = i + b;
+        nd += (respawn >> b) & 1;
+    }
+    alive = _mm_and_ps(alive, inside);
+    if (!(aliveMask & insideMask)) return n; // nothing in view, skip the divide
+
+    __m128 f = _mm_div_ps(focal, z);
+    __m128 px = _mm_add_ps(_mm_set1_ps(p.cx), _mm_mul_ps(x, f));
+    __m128 py = _mm_add_ps(_mm_set1_ps(p.cy), _mm_mul_ps(y, f));
+
+    // size = ceil(clamp(SIZE_SCALE * Z_MIN / z, 1, MAX_PSZ)); SSE2 has no ceil, so truncate and bump
+    __m128 sz = _mm_mul_ps(_mm_set1_ps(Cfg::sizeK * p.sizeScale), f);
+    sz = _mm_min_ps(_mm_max_ps(sz, one), _mm_set1_ps((float)Cfg::maxPsz));
+    __m128i isz = _mm_cvttps_epi32(sz);
+    isz = _mm_sub_epi32(isz, _mm_castps_si128(_mm_cmplt_ps(_mm_cvtepi32_ps(isz), sz)));
+    sz = _mm_cvtepi32_ps(isz);
+
+    // onscreen test
+    __m128 vis = _mm_and_ps(
+        _mm_and_ps(_mm_cmpge_ps(_mm_add_ps(px, sz), _mm_setzero_ps()), _mm_cmple_ps(_mm_sub_ps(px, sz), _mm_set1_ps(p.w))),
+        _mm_and_ps(_mm_cmpge_ps(_mm_add_ps(py, sz), _mm_setzero_ps()), _mm_cmple_ps(_mm_sub_ps(py, sz), _mm_set1_ps(p.h))));
+    int mask = _mm_movemask_ps(_mm_and_ps(vis, alive));
+    if (!mask) return n;
+
+    // intensity and bucket; intensity < 256 so the bucket never exceeds BUCKETS - 1
+    __m128 in = _mm_add_ps(_mm_set1_ps(p.i0), _mm_mul_ps(_mm_set1_ps(p.i1), z));
+    in = _mm_min_ps(_mm_max_ps(in, _mm_setzero_ps()), _mm_set1_ps(255.0f));
+    in = _mm_cvtepi32_ps(_mm_cvtps_epi32(in));
+    __m128i bk = _mm_cvttps_epi32(_mm_mul_ps(in, _mm_set1_ps(Cfg::bucketK)));
+
+    // compact the visible lanes into the output
+    alignas(16) float tpx[4], tpy[4], tz[4];
+    alignas(16) int tsz[4], tbk[4];
+    _mm_store_ps(tz, z);
+    _mm_store_ps(tpx, px);
+    _mm_store_ps(tpy, py);
+    _mm_store_si128((__m128i*)tsz, isz);
+    _mm_store_si128((__m128i*)tbk, bk);
+    for (int b = 0; b < 4; ++b)
+    {
+        if (!(mask & (1 << b))) continue;
+        out.px[n] = tpx[b];
+        out.py[n] = tpy[b];
+        out.psz[n] = (uint8_t)tsz[b];
+        out.bucket[n] = (uint8_t)tbk[b];
+        if (p.streak) ProjectTail<Compact>(st, out, p, i + b, tz[b], n);
+        ++n;
+    }
+    return n;
+}
+
+template <typename Cfg, bool Analytic, bool Compact>
+static int SimulateSSE2(StarSoA& st, ProjectedStars& out, int* dead, int& nd, const SimParams& p, int begin, int end, int n)
+{
+    for (int i = begin; i + 8 <= end; i += 8)
+    {
+        n = SimulateSSE2Lanes<Cfg, Analytic, Compact>(st, out, dead, nd, p, i, n);
+        n = SimulateSSE2Lanes<Cfg, Analytic, Compact>(st, out, dead, nd, p, i + 4, n);
+    }
+    return n;
+}
+
+// Compact stars i..i+7, as UnpackSSE2
+STAR_TARGET_AVX2
+static inline void UnpackAVX2(const StarSoA& st, int i, __m256& x, __m256& y, __m256& z, __m256& speed)
+{
+    __m256i qx = _mm256_cvtepi16_epi32(_mm_load_si128((const __m128i*)(st.qx.data + i)));
+    __m256i qy = _mm256_cvtepi16_epi32(_mm_load_si128((const __m128i*)(st.qy.data + i)));
+    __m256i qz = _mm256_cvtepu16_epi32(_mm_load_si128((const __m128i*)(st.qz.data + i)));
+    __m256i qs = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(st.qspeed.data + i)));
+    x = _mm256_mul_ps(_mm256_cvtepi32_ps(qx), _mm256_set1_ps(st.qScaleX));
+    y = _mm256_mul_ps(_mm256_cvtepi32_ps(qy), _mm256_set1_ps(st.qScaleY));
+    z = _mm256_mul_ps(_mm256_cvtepi32_ps(qz), _mm256_set1_ps(Z_QSTEP));
+    speed = _mm256_add_ps(_mm256_set1_ps(st.qSpeed0), _mm256_cvtepi32_ps(qs));
+}
+
+// AVX2 kernel: 8 lanes per iteration
+template <typename Cfg, bool Analytic, bool Compact>
+STAR_TARGET_AVX2
+static int SimulateAVX2(StarSoA& st, ProjectedStars& out, int* dead, int& nd, const SimParams& p, int begin, int end, int n)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 zStep = _mm256_set1_ps(p.zStep);
+    const __m256 zMin = _mm256_set1_ps(Z_MIN);
+    const __m256 focal = _mm256_set1_ps(FOCAL);
+    const __m256 sizeK = _mm256_set1_ps(Cfg::sizeK * p.sizeScale);
+    const __m256 maxPsz = _mm256_set1_ps((float)Cfg::maxPsz);
+    const __m256 cx = _mm256_set1_ps(p.cx), cy = _mm256_set1_ps(p.cy);
+    const __m256 vw = _mm256_set1_ps(p.w), vh = _mm256_set1_ps(p.h);
+    const __m256 i0 = _mm256_set1_ps(p.i0), i1 = _mm256_set1_ps(p.i1);
+    const __m256 i255 = _mm256_set1_ps(255.0f);
+    const __m256 bucketK = _mm256_set1_ps(Cfg::bucketK);
+    const __m256 coneL = _mm256_set1_ps(-(p.cx + Cfg::maxPsz)), coneR = _mm256_set1_ps(p.w - p.cx + Cfg::maxPsz);
+    const __m256 coneT = _mm256_set1_ps(-(p.cy + Cfg::maxPsz)), coneB = _mm256_set1_ps(p.h - p.cy + Cfg::maxPsz);
+    const int recycle = -p.recycle;
+    const __m256 zPhase = _mm256_set1_ps(p.zPhase);
+    const __m256 zRange = _mm256_set1_ps(Z_RANGE), invRange = _mm256_set1_ps(1.0f / Z_RANGE);
+    alignas(32) float tpx[8], tpy[8], tz[8];
+    alignas(32) int tsz[8], tbk[8];
+
+    for (int i = begin; i + 8 <= end; i += 8)
+    {
+        __m256 x, y, z, speed;
+        if (Compact) UnpackAVX2(st, i, x, y, z, speed);
+        else
+        {
+            x = _mm256_load_ps(st.x.data + i);
+            y = _mm256_load_ps(st.y.data + i);
+            z = _mm256_load_ps(st.z.data + i);
+            speed = _mm256_load_ps(st.speed.data + i);
+        }
+        __m256 alive;
+        if (Analytic)
+        {
+            __m256 zOff = Compact ? z : _mm256_sub_ps(z, zMin);
+            __m256 u = _mm256_sub_ps(zOff, _mm256_mul_ps(speed, zPhase));
+            __m256 fq = _mm256_floor_ps(_mm256_mul_ps(u, invRange));
+            z = _mm256_add_ps(zMin, _mm256_sub_ps(u, _mm256_mul_ps(zRange, fq)));
+            alive = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        }
+        else
+        {
+            z = _mm256_sub_ps(z, _mm256_mul_ps(speed, zStep));
+            _mm256_store_ps(st.z.data + i, z);
+            alive = _mm256_cmp_ps(z, zMin, _CMP_GT_OQ);
+        }
+        __m256 xf = _mm256_mul_ps(x, focal), yf = _mm256_mul_ps(y, focal);
+        __m256 inside = _mm256_and_ps(
+            _mm256_and_ps(_mm256_cmp_ps(xf, _mm256_mul_ps(coneL, z), _CMP_GE_OQ), _mm256_cmp_ps(xf, _mm256_mul_ps(coneR, z), _CMP_LE_OQ)),
+            _mm256_and_ps(_mm256_cmp_ps(yf, _mm256_mul_ps(coneT, z), _CMP_GE_OQ), _mm256_cmp_ps(yf, _mm256_mul_ps(coneB, z), _CMP_LE_OQ)));
+        int aliveMask = _mm256_movemask_ps(alive);
+        int insideMask = _mm256_movemask_ps(inside);
+        int respawn = (~aliveMask | (~insideMask & recycle)) & 255;
+        for (int b = 0; b < 8; ++b)
+        {
+            dead[nd] = i + b;
+            nd += (respawn >> b) & 1;
+        }
+        alive = _mm256_and_ps(alive, inside);
+        if (!(aliveMask & insideMask)) continue; // nothing in view, skip the divide
+
+        __m256 f = _mm256_div_ps(focal, z);
+        __m256 px = _mm256_add_ps(cx, _mm256_mul_ps(x, f));
+        __m256 py = _mm256_add_ps(cy, _mm256_mul_ps(y, f));
+        __m256 sz = _mm256_ceil_ps(_mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(sizeK, f), one), maxPsz));
+
+        __m256 vis = _mm256_and_ps(
+            _mm256_and_ps(_mm256_cmp_ps(_mm256_add_ps(px, sz), zero, _CMP_GE_OQ), _mm256_cmp_ps(_mm256_sub_ps(px, sz), vw, _CMP_LE_OQ)),
+            _mm256_and_ps(_mm256_cmp_ps(_mm256_add_ps(py, sz), zero, _CMP_GE_OQ), _mm256_cmp_ps(_mm256_sub_ps(py, sz), vh, _CMP_LE_OQ)));
+        int mask = _mm256_movemask_ps(_mm256_and_ps(vis, alive));
+        if (!mask) continue;
+
+        __m256 in = _mm256_min_ps(_mm256_max_ps(_mm256_add_ps(i0, _mm256_mul_ps(i1, z)), zero), i255);
+        in = _mm256_round_ps(in, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m256i bk = _mm256_cvttps_epi32(_mm256_mul_ps(in, bucketK));
+
+        _mm256_store_ps(tz, z);
+        _mm256_store_ps(tpx, px);
+        _mm256_store_ps(tpy, py);
+        _mm256_store_si256((__m256i*)tsz, _mm256_cvttps_epi32(sz));
+        _mm256_store_si256((__m256i*)tbk, bk);
+        for (int b = 0; b < 8; ++b)
+        {
+            if (!(mask & (1 << b))) continue;
+            out.px[n] = tpx[b];
+            out.py[n] = tpy[b];
+            out.psz[n] = (uint8_t)tsz[b];
+            out.bucket[n] = (uint8_t)tbk[b];
+            if (p.streak) ProjectTail<Compact>(st, out, p, i + b, tz[b], n);
+            ++n;
+        }
+    }
+    return n;
+}
+
+// Re-initialize the queued stars in one go, the same way InitStars fills the field
+static void RespawnStars(StarSoA& st, StarRng& rng, const int* idx, int count, const SpawnParams& sp)
+{
+    for (int k = 0; k < count; ++k) RespawnStar(st, rng, idx[k], sp);
+}
+
+// Kernel dispatch: [stepped, analytic, compact][profile][SimdLevel]
+typedef int (*SimKernel)(StarSoA&, ProjectedStars&, int*, int&, const SimParams&, int, int, int);
+static const SimKernel g_SimKernels[3][PROFILE_COUNT][3] =
+{
+    {
+        { SimulateScalar<FullscreenProfile, false, false>, SimulateSSE2<FullscreenProfile, false, false>, SimulateAVX2<FullscreenProfile, false, false> },
+        { SimulateScalar<PreviewProfile, false, false>, SimulateSSE2<PreviewProfile, false, false>, SimulateAVX2<PreviewProfile, false, false> },
+    },
+    {
+        { SimulateScalar<FullscreenProfile, true, false>, SimulateSSE2<FullscreenProfile, true, false>, SimulateAVX2<FullscreenProfile, true, false> },
+        { SimulateScalar<PreviewProfile, true, false>, SimulateSSE2<PreviewProfile, true, false>, SimulateAVX2<PreviewProfile, true, false> },
+    },
+    {
+        { SimulateScalar<FullscreenProfile, true, true>, SimulateSSE2<FullscreenProfile, true, true>, SimulateAVX2<FullscreenProfile, true, true> },
+        { SimulateScalar<PreviewProfile, true, true>, SimulateSSE2<PreviewProfile, true, true>, SimulateAVX2<PreviewProfile, true, true> },
+    },
+};
+
+// Best kernel over [begin, end), scalar for the tail, then the respawn batch.
+// dead is scratch for end - begin indices; respawns draw from the calling thread's rng.
+static int SimulateRange(StarSoA& st, ProjectedStars& out, int* dead, StarRng& rng, const SimParams& p, int begin, int end, int n)
+{
+    int nd = 0;
+    // the layout picks the compact kernels, they are analytic whatever p says
+    const SimKernel* kernels = g_SimKernels[st.compact ? 2 : p.analytic][p.profile];
+    int vecEnd = (g_Simd == SIMD_NONE) ? begin : begin + ((end - begin) & ~7);
+    if (g_Simd != SIMD_NONE) n = kernels[g_Simd](st, out, dead, nd, p, begin, vecEnd, n);
+    n = kernels[SIMD_NONE](st, out, dead, nd, p, vecEnd, end, n);
+    RespawnStars(st, rng, dead, nd, p.spawn);
+    return n;
+}
+
+// ---- Chunked parallel simulate
+// Stars are split in SIM_CHUNK sized chunks (a multiple of 16 floats, so every chunk
+// starts on a cache line). Chunk c writes its visible stars to its own slice of the
+// output at c * SIM_CHUNK, the slices are packed afterwards.
+static const int SIM_CHUNK = 4096;
+
+// Small persistent pool with per-thread chunk ranges and stealing from the back of
+// other threads' ranges. Slot 0 is whichever thread submits the job. One job at a
+// time: a render worker that finds the pool busy (another monitor) runs serially.
+struct SimPool
+{
+    struct Slot
+    {
+        std::mutex mutex;
+        int next = 0;
+        int end = 0;
+        StarRng rng; // per-thread RNG for respawns
+    };
+    std::vector<std::thread> threads;
+    std::unique_ptr<Slot[]> slots;
+    int numSlots = 0;
+    std::mutex jobMutex;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::condition_variable doneCv;
+    unsigned long long job = 0;
+    int active = 0;
+    bool stop = false;
+    const std::function<void(int, StarRng&)>* fn = nullptr;
+    // Reseed: respawns draw from a stream per (seed, pass, chunk) instead of the thread's,
+    // so stealing can't change the field. Single submitter only (benchmark, offline capture).
+    bool seeded = false;
+    uint64_t seed = 0;
+    uint64_t pass = 0;
+
+    void Start(int numThreads)
+    {
+        if (numThreads < 1 || numSlots) return;
+        numSlots = numThreads + 1;
+        slots.reset(new Slot[numSlots]);
+        std::random_device rd;
+        for (int i = 0; i < numSlots; ++i) slots[i].rng.Seed(((uint64_t)rd() << 32) | rd());
+        seeded = false;
+        stop = false;
+        for (int i = 1; i < numSlots; ++i) threads.emplace_back(&SimPool::ThreadMain, this, i);
+    }
+    // deterministic respawns from here on, see ChunkSeed
+    void Reseed(uint32_t s)
+    {
+        seeded = true;
+        seed = s;
+        pass = 0;
+    }
+    uint64_t ChunkSeed(uint64_t jobPass, int chunk) const
+    {
+        return (seed * 0x9E3779B97F4A7C15ull) ^ (jobPass << 32) ^ (uint64_t)(uint32_t)chunk;
+    }
+    void Shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            stop = true;
+            cv.notify_all();
+        }
+        for (auto& t : threads) t.join();
+        threads.clear();
+        slots.reset();
+        numSlots = 0;
+    }
+    bool PopOwn(int s, int& chunk)
+    {
+        std::lock_guard<std::mutex> lk(slots[s].mutex);
+        if (slots[s].next >= slots[s].end) return false;
+        chunk = slots[s].next++;
+        return true;
+    }
+    bool Steal(int s, int& chunk)
+    {
+        for (int k = 1; k < numSlots; ++k)
+        {
+            Slot& v = slots[(s + k) % numSlots];
+            std::lock_guard<std::mutex> lk(v.mutex);
+            if (v.next < v.end)
+            {
+                chunk = --v.end;
+                return true;
+            }
+        }
+        return false;
+    }
+    void Work(int s, StarRng& rng)
+    {
+        int chunk;
+        while (PopOwn(s, chunk) || Steal(s, chunk)) (*fn)(chunk, rng);
+    }
+    void ThreadMain(int s)
+    {
+        unsigned long long seen = 0;
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lk(mutex);
+                cv.wait(lk, [&] { return stop || job != seen; });
+                if (stop) return;
+                seen = job;
+            }
+            Work(s, slots[s].rng);
+            std::lock_guard<std::mutex> lk(mutex);
+            if (--active == 0) doneCv.notify_all();
+        }
+    }
+    // Run f(chunk, rng) for chunk in [0, numChunks); callerRng serves the submitting thread
+    void ParallelFor(int numChunks, const std::function<void(int, StarRng&)>& f, StarRng& callerRng)
+    {
+        std::unique_lock<std::mutex> busy(jobMutex, std::try_to_lock);
+        if (!busy.owns_lock() || numSlots < 2)
+        {
+            for (int c = 0; c < numChunks; ++c) f(c, callerRng);
+            return;
+        }
+        // contiguous starting ranges, stealing evens it out
+        for (int i = 0; i < numSlots; ++i)
+        {
+            std::lock_guard<std::mutex> lk(slots[i].mutex);
+            slots[i].next = numChunks * i / numSlots;
+            slots[i].end = numChunks * (i + 1) / numSlots;
+        }
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            fn = &f;
+            active = numSlots - 1;
+            ++job;
+            cv.notify_all();
+        }
+        Work(0, callerRng);
+        std::unique_lock<std::mutex> lk(mutex);
+        doneCv.wait(lk, [&] { return active == 0; });
+    }
+};
+static SimPool g_SimPool;
+
+// Simulate the first count stars of st into out, chunked over the pool when it pays
+static void SimulateField(StarSoA& st, ProjectedStars& out, int count, const SimParams& p, StarRng& rng,
+    AlignedBuffer<int>& respawnQueue, std::vector<int>& chunkCounts)
+{
+    out.reserve(count);
+    out.tails = p.streak != 0;
+    respawnQueue.reserve(count);
+    int* dead = respawnQueue.data;
+    int chunks = (count + SIM_CHUNK - 1) / SIM_CHUNK;
+    if (chunks < 2 || g_SimPool.numSlots < 2)
+    {
+        out.count = SimulateRange(st, out, dead, rng, p, 0, count, 0);
+        return;
+    }
+    chunkCounts.resize(chunks);
+    bool seeded = g_SimPool.seeded;
+    uint64_t pass = seeded ? g_SimPool.pass++ : 0;
+    g_SimPool.ParallelFor(chunks, [&](int c, StarRng& chunkRng)
+    {
+        int b = c * SIM_CHUNK;
+        int e = min(count, b + SIM_CHUNK);
+        if (!seeded)
+        {
+            chunkCounts[c] = SimulateRange(st, out, dead + b, chunkRng, p, b, e, b) - b;
+            return;
+        }
+        // whichever thread runs the chunk, its respawns are the same
+        StarRng own;
+        own.Seed(g_SimPool.ChunkSeed(pass, c));
+        chunkCounts[c] = SimulateRange(st, out, dead + b, own, p, b, e, b) - b;
+    }, rng);
+    // pack the per-chunk slices
+    int n = chunkCounts[0];
+    for (int c = 1; c < chunks; ++c)
+    {
+        int src = c * SIM_CHUNK, k = chunkCounts[c];
+        memmove(out.px.data + n, out.px.data + src, k * sizeof(float));
+        memmove(out.py.data + n, out.py.data + src, k * sizeof(float));
+        memmove(out.psz.data + n, out.psz.data + src, k);
+        memmove(out.bucket.data + n, out.bucket.data + src, k);
+        if (out.tails)
+        {
+            memmove(out.tx.data + n, out.tx.data + src, k * sizeof(float));
+            memmove(out.ty.data + n, out.ty.data + src, k * sizeof(float));
+        }
+        n += k;
+    }
+    out.count = n;
+}
+
+// Simulate all stars, fills rw->proj with the visible ones
+static void SimulateStars(RenderWindow* rw, const SimParams& p)
+{
+    StarSoA& st = rw->field ? *rw->field : rw->stars;
+    int count = st.size();
+    int limit = rw->activeStars;
+    if (limit > 0) count = min(count, limit); // the rest stays frozen
+    if (rw->gov.level) count = max(1, count * rw->gov.StarsPct() / 100);
+    SimulateField(st, rw->proj, count, p, rw->rng, rw->respawnQueue, rw->chunkCounts);
+    rw->simulated = count;
+}
+
+// Shared field, desktop pass: every star once, then each window's slice cut out of the
+// visible ones. One field means one star budget, so the most degraded window (governor,
+// power throttle) sets the star count and pulse for all of them.
+static void ProjectShared(SharedFrame& f, float dt, double totalTime)
+{
+    SharedField& sh = g_Shared;
+    int nw = (int)sh.passSlices.size();
+    int count = sh.stars.size(), level = 0;
+    for (RenderWindow* rw : g_Windows)
+    {
+        level = max(level, (int)rw->govLevel);
+        int limit = rw->activeStars;
+        if (limit > 0) count = min(count, limit);
+    }
+    if (level) count = max(1, count * g_GovStarsPct[level] / 100);
+    int w = max(1, sh.rc.right - sh.rc.left), h = max(1, sh.rc.bottom - sh.rc.top);
+    SimParams p = MakeSimParams(w, h, dt, totalTime, sh.speed, PROFILE_FULLSCREEN, sh.dpi / 96.0f, level < GOV_FX_LEVEL);
+    SimulateField(sh.stars, f.desktop, count, p, sh.rng, sh.respawnQueue, sh.chunkCounts);
+    if (!f.views) f.views.reset(new ProjectedStars[nw]);
+    const ProjectedStars& src = f.desktop;
+    for (int v = 0; v < nw; ++v)
+    {
+        const SharedSlice& sl = sh.passSlices[v];
+        ProjectedStars& out = f.views[v];
+        out.reserve(src.count);
+        out.tails = src.tails;
+        int n = 0;
+        for (int i = 0; i < src.count; ++i)
+        {
+            float px = src.px[i] - sl.ox, py = src.py[i] - sl.oy;
+            int psz = src.psz[i];
+            // a lower DPI monitor: the kernel's size, rounded up, at its own scale
+            if (sl.dpi != sh.dpi) psz = max(1, (int)((psz * sl.dpi + sh.dpi - 1) / sh.dpi));
+            // the kernels' offscreen test against this window
+            if (px + psz < 0 || px - psz > sl.w || py + psz < 0 || py - psz > sl.h) continue;
+            out.px[n] = px;
+            out.py[n] = py;
+            out.psz[n] = (uint8_t)psz;
+            out.bucket[n] = src.bucket[i];
+            if (src.tails)
+            {
+                out.tx[n] = src.tx[i] - sl.ox;
+                out.ty[n] = src.ty[i] - sl.oy;
+            }
+            ++n;
+        }
+        out.count = n;
+    }
+    f.time = totalTime;
+    f.simulated = count;
+}
+
+// Shared field, per window: copy this window's slice of the desktop pass for this frame.
+// A pass within half a frame of ours is reused, so monitors at the same rate share one
+// pass whatever their vblank phase; a missing or stale one is made here.
+static void SimulateShared(RenderWindow* rw, float dt, double totalTime)
+{
+    SharedField& sh = g_Shared;
+    int fps = rw->targetFps > 0 ? (int)rw->targetFps : rw->refreshHz;
+    double tolerance = 0.5 / max(1, fps);
+    SharedFrame* f = nullptr;
+    {
+        std::unique_lock<std::mutex> lk(sh.frameMutex);
+        for (;;)
+        {
+            if (sh.latest >= 0 && fabs(sh.frames[sh.latest].time - totalTime) <= tolerance)
+            {
+                f = &sh.frames[sh.latest];
+                break;
+            }
+            if (!sh.writing)
+            {
+                int k = 0;
+                while (k < SHARED_FRAMES && (k == sh.latest || sh.frames[k].readers)) ++k;
+                if (k < SHARED_FRAMES)
+                {
+                    sh.writing = true;
+                    sh.passSlices = sh.slices;
+                    lk.unlock();
+                    ProjectShared(sh.frames[k], dt, totalTime);
+                    lk.lock();
+                    sh.writing = false;
+                    sh.latest = k;
+                    f = &sh.frames[k];
+                    sh.frameCv.notify_all();
+                    break;
+                }
+            }
+            sh.frameCv.wait(lk); // a pass in flight (likely ours), or every frame still being copied
+        }
+        ++f->readers;
+    }
+    const ProjectedStars& src = f->views[rw->index];
+    ProjectedStars& out = rw->proj;
+    int n = src.count;
+    out.reserve(n);
+    out.tails = src.tails;
+    memcpy(out.px.data, src.px.data, n * sizeof(float));
+    memcpy(out.py.data, src.py.data, n * sizeof(float));
+    memcpy(out.psz.data, src.psz.data, n);
+    memcpy(out.bucket.data, src.bucket.data, n);
+    if (src.tails)
+    {
+        memcpy(out.tx.data, src.tx.data, n * sizeof(float));
+        memcpy(out.ty.data, src.ty.data, n * sizeof(float));
+    }
+    out.count = n;
+    rw->simulated = f->simulated;
+    {
+        std::lock_guard<std::mutex> lk(sh.frameMutex);
+        --f->readers;
+    }
+    sh.frameCv.notify_all();
+}
+
+// ---- Damage tracking for the incremental GDI/DIB mode
+// The surface is cut in horizontal bands of BAND_H rows, each split in TILE_W wide tiles.
+// Boxes of drawn stars mark tiles dirty; erasing and presenting then cost one fill / blit
+// per run of dirty tiles in a band instead of a full-screen FillRect + BitBlt.
+static const int BAND_H = 32;
+static const int TILE_W = 64;
+
+struct DamageBands
+{
+    std::vector<uint8_t> dirty; // bands * cols
+    int cols = 0;
+    int bands = 0;
+    int width = 0;
+    int height = 0;
+
+    void Reset(int w, int h)
+    {
+        width = w;
+        height = h;
+        cols = (w + TILE_W - 1) / TILE_W;
+        bands = (h + BAND_H - 1) / BAND_H;
+        dirty.assign((size_t)cols * bands, 0);
+    }
+    // add box [l, r) x [t, b), clipped to the surface
+    void Add(int l, int t, int r, int b)
+    {
+        l = max(0, l); t = max(0, t);
+        r = min(width, r); b = min(height, b);
+        if (l >= r || t >= b) return;
+        int c0 = l / TILE_W, c1 = (r - 1) / TILE_W;
+        for (int band = t / BAND_H, last = (b - 1) / BAND_H; band <= last; ++band)
+        {
+            uint8_t* row = &dirty[(size_t)band * cols];
+            for (int c = c0; c <= c1; ++c) row[c] = 1;
+        }
+    }
+    void Merge(const DamageBands& o)
+    {
+        if (o.dirty.size() != dirty.size()) return;
+        for (size_t i = 0; i < dirty.size(); ++i) dirty[i] |= o.dirty[i];
+    }
+    long long Area() const
+    {
+        long long n = 0;
+        for (uint8_t d : dirty) n += d;
+        return n * TILE_W * BAND_H;
+    }
+    // calls f(l, t, r, b) per run of dirty tiles in each band
+    template <typename F> void ForEachRect(F f) const
+    {
+        for (int band = 0; band < bands; ++band)
+        {
+            const uint8_t* row = &dirty[(size_t)band * cols];
+            int t = band * BAND_H, b = min(height, t + BAND_H);
+            for (int c = 0; c < cols; )
+            {
+                if (!row[c]) { ++c; continue; }
+                int end = c + 1;
+                while (end < cols && row[end]) ++end;
+                f(c * TILE_W, t, min(width, end * TILE_W), b);
+                c = end;
+            }
+        }
+    }
+};
+
+// ---- Draw pass: consumes rw->proj
+// Representative intensity of a bucket: its midpoint, clamped to the 100..255 stars reach
+static int BucketIntensity(int bucket)
+{
+    int mid = (int)((bucket + 0.5f) * (256.0f / BUCKETS));
+    return max(100, min(255, mid));
+}
+
+// Streak mode: every star is a line from its tail to its head, only stars bigger than
+// this still get a disc / glow on top
+static const int STREAK_HEAD_PSZ = 2;
+
+// Pixel and quad LOD tiers, one add per pixel straight into the DIB
+static inline void BlendPixel(RenderWindow* rw, int x, int y, uint32_t c)
+{
+    if ((unsigned)x >= (unsigned)rw->bitsW || (unsigned)y >= (unsigned)rw->bitsH) return;
+    uint32_t* px = rw->bits + (size_t)y * rw->bitsStride + x;
+    *px = AddSaturate(*px, c);
+}
+
+// dmg (optional) collects the box of every star drawn; stars of radius <= minPsz are skipped.
+// Within a bucket the draw list runs small to large, so the LOD tiers come first.
+static void DrawStarsDib(RenderWindow* rw, const uint32_t glow[BUCKETS][256], DamageBands* dmg, int minPsz = 0)
+{
+    const ProjectedStars& ps = rw->proj;
+    const DrawList& dl = rw->drawList;
+    const int lodPixel = min(MAX_PSZ, g_LodPixel + rw->gov.LodBoost()), lodQuad = min(MAX_PSZ, g_LodQuad + rw->gov.LodBoost());
+    for (int b = 0; b < BUCKETS; ++b)
+    {
+        uint32_t c = glow[b][255];
+        for (int k = dl.first[b]; k < dl.first[b + 1]; ++k)
+        {
+            int i = dl.order[k];
+            if (ps.psz[i] <= minPsz) continue;
+            int cx = (int)lroundf(ps.px[i]), cy = (int)lroundf(ps.py[i]), r = ps.psz[i];
+            if (r <= lodQuad)
+            {
+                int q = r > lodPixel; // 0: pixel, 1: 2x2
+                BlendPixel(rw, cx, cy, c);
+                if (q)
+                {
+                    BlendPixel(rw, cx + 1, cy, c);
+                    BlendPixel(rw, cx, cy + 1, c);
+                    BlendPixel(rw, cx + 1, cy + 1, c);
+                }
+                if (dmg) dmg->Add(cx, cy, cx + 1 + q, cy + 1 + q);
+                ++rw->lodCounts[q];
+                continue;
+            }
+            ++rw->lodCounts[2];
+            BlendGlow(rw, cx, cy, r, glow[b]);
+            int e = GlowExtent(r);
+            if (dmg) dmg->Add(cx - e, cy - e, cx + e + 1, cy + e + 1);
+        }
+    }
+}
+
+// Additive anti-aliased (Wu) line from (x0, y0) to (x1, y1), clipped to the DIB:
+// two pixels per step along the major axis, split by the minor coordinate's fraction
+static void BlendLine(RenderWindow* rw, float x0, float y0, float x1, float y1, const uint32_t table[256])
+{
+    bool steep = fabsf(y1 - y0) > fabsf(x1 - x0);
+    if (steep)
+    {
+        std::swap(x0, y0);
+        std::swap(x1, y1);
+    }
+    if (x0 > x1)
+    {
+        std::swap(x0, x1);
+        std::swap(y0, y1);
+    }
+    int major = steep ? rw->bitsH : rw->bitsW, minor = steep ? rw->bitsW : rw->bitsH;
+    float grad = (x1 - x0) > 0.0f ? (y1 - y0) / (x1 - x0) : 0.0f;
+    int xa = max(0, (int)lroundf(x0)), xb = min(major - 1, (int)lroundf(x1));
+    float y = y0 + grad * ((float)xa - x0);
+    for (int x = xa; x <= xb; ++x, y += grad)
+    {
+        int iy = (int)floorf(y);
+        int a = (int)((y - (float)iy) * 255.0f + 0.5f);
+        for (int k = 0; k < 2; ++k, ++iy)
+        {
+            if (iy < 0 || iy >= minor) continue;
+            uint32_t* px = steep ? rw->bits + (size_t)x * rw->bitsStride + iy : rw->bits + (size_t)iy * rw->bitsStride + x;
+            *px = AddSaturate(*px, table[k ? a : 255 - a]);
+        }
+    }
+}
+
+// Streak mode on the DIB: AA tail lines, then the heads of the big ones
+static void DrawStreaksDib(RenderWindow* rw, const uint32_t glow[BUCKETS][256], DamageBands* dmg)
+{
+    const ProjectedStars& ps = rw->proj;
+    const DrawList& dl = rw->drawList;
+    for (int b = 0; b < BUCKETS; ++b)
+    {
+        for (int k = dl.first[b]; k < dl.first[b + 1]; ++k)
+        {
+            int i = dl.order[k];
+            BlendLine(rw, ps.tx[i], ps.ty[i], ps.px[i], ps.py[i], glow[b]);
+            if (dmg)
+            {
+                int l = (int)floorf(min(ps.tx[i], ps.px[i])) - 1, t = (int)floorf(min(ps.ty[i], ps.py[i])) - 1;
+                int r = (int)ceilf(max(ps.tx[i], ps.px[i])) + 2, bt = (int)ceilf(max(ps.ty[i], ps.py[i])) + 2;
+                dmg->Add(l, t, r, bt);
+            }
+        }
+    }
+    DrawStarsDib(rw, glow, dmg, STREAK_HEAD_PSZ);
+}
+
+// Reused PolyPolygon / PolyPolyline input, capacity survives across frames
+struct PolyBatch
+{
+    std::vector<POINT> points;
+    std::vector<INT> counts;
+    std::vector<DWORD> lineCounts;
+};
+
+// One PolyPolygon per bucket. backHdc must have NULL_PEN and WINDING selected,
+// so overlapping discs of a batch fill as their union.
+static void DrawStarsGdi(RenderWindow* rw, const HBRUSH brushes[BUCKETS], PolyBatch& batch, DamageBands* dmg, int minPsz = 0)
+{
+    const ProjectedStars& ps = rw->proj;
+    const DrawList& dl = rw->drawList;
+    const int lodPixel = min(MAX_PSZ, g_LodPixel + rw->gov.LodBoost()), lodQuad = min(MAX_PSZ, g_LodQuad + rw->gov.LodBoost());
+    HGDIOBJ oldBrush = SelectObject(rw->backHdc, brushes[0]);
+    for (int b = 0; b < BUCKETS; ++b)
+    {
+        if (dl.first[b] == dl.first[b + 1]) continue;
+        batch.points.clear();
+        batch.counts.clear();
+        for (int k = dl.first[b]; k < dl.first[b + 1]; ++k)
+        {
+            int i = dl.order[k];
+            if (ps.psz[i] <= minPsz) continue;
+            int cx = (int)lroundf(ps.px[i]), cy = (int)lroundf(ps.py[i]), r = ps.psz[i];
+            if (r <= lodQuad)
+            {
+                // 1x1 / 2x2 square, GDI fills up to but not including the right and bottom edge
+                int q = r > lodPixel, e = 1 + q;
+                batch.points.push_back({ cx, cy });
+                batch.points.push_back({ cx + e, cy });
+                batch.points.push_back({ cx + e, cy + e });
+                batch.points.push_back({ cx, cy + e });
+                batch.counts.push_back(4);
+                if (dmg) dmg->Add(cx, cy, cx + e, cy + e);
+                ++rw->lodCounts[q];
+                continue;
+            }
+            ++rw->lodCounts[2];
+            const std::vector<POINT>& outline = g_DiscOutlines[r];
+            for (const POINT& pt : outline) batch.points.push_back({ cx + pt.x, cy + pt.y });
+            batch.counts.push_back((INT)outline.size());
+            if (dmg) dmg->Add(cx - r, cy - r, cx + r + 1, cy + r + 1);
+        }
+        if (batch.counts.empty()) continue;
+        SelectObject(rw->backHdc, brushes[b]);
+        PolyPolygon(rw->backHdc, batch.points.data(), batch.counts.data(), (int)batch.counts.size());
+    }
+    SelectObject(rw->backHdc, oldBrush);
+}
+
+// Streak mode on GDI: one PolyPolyline of tail segments per bucket (cosmetic pens, no AA),
+// then the heads of the big ones. NULL_PEN goes back in for the PolyPolygon batches.
+static void DrawStreaksGdi(RenderWindow* rw, const HBRUSH brushes[BUCKETS], const HPEN pens[BUCKETS], PolyBatch& batch, DamageBands* dmg)
+{
+    const ProjectedStars& ps = rw->proj;
+    const DrawList& dl = rw->drawList;
+    for (int b = 0; b < BUCKETS; ++b)
+    {
+        if (dl.first[b] == dl.first[b + 1]) continue;
+        batch.points.clear();
+        batch.lineCounts.clear();
+        for (int k = dl.first[b]; k < dl.first[b + 1]; ++k)
+        {
+            int i = dl.order[k];
+            POINT t = { (LONG)lroundf(ps.tx[i]), (LONG)lroundf(ps.ty[i]) };
+            POINT h = { (LONG)lroundf(ps.px[i]), (LONG)lroundf(ps.py[i]) };
+            // a zero length segment draws nothing
+            if (t.x == h.x && t.y == h.y) ++h.x;
+            batch.points.push_back(t);
+            batch.points.push_back(h);
+            batch.lineCounts.push_back(2);
+            if (dmg) dmg->Add(min(t.x, h.x), min(t.y, h.y), max(t.x, h.x) + 1, max(t.y, h.y) + 1);
+        }
+        SelectObject(rw->backHdc, pens[b]);
+        PolyPolyline(rw->backHdc, batch.points.data(), batch.lineCounts.data(), (DWORD)batch.lineCounts.size());
+    }
+    SelectObject(rw->backHdc, GetStockObject(NULL_PEN));
+    DrawStarsGdi(rw, brushes, batch, dmg, STREAK_HEAD_PSZ);
+}
+
+// HUD: stats text in the top left corner
+static const RECT g_HudRect = { 8, 8, 8 + 560, 8 + 144 };
+
+static void DrawHudText(HDC hdc, const char* text)
+{
+    RECT rc = g_HudRect;
+    HGDIOBJ oldFont = SelectObject(hdc, GetStockObject(ANSI_FIXED_FONT));
+    SetBkMode(hdc, TRANSPARENT);
+    SetTextColor(hdc, RGB(120, 255, 120));
+    DrawTextA(hdc, text, -1, &rc, DT_LEFT | DT_TOP | DT_NOCLIP | DT_NOPREFIX);
+    SelectObject(hdc, oldFont);
+}
+
+// ---- Renderer backends
+// GDI / DIB: CPU backbuffer, stars drawn into it and BitBlt to the window.
+// GDI objects live as long as the window so a steady-state frame allocates none.
+struct GdiRenderer : StarRenderer
+{
+    bool dib;
+    HWND hwnd = NULL;
+    HDC wndDc = NULL;              // CS_OWNDC window DC, held until Destroy
+    HBRUSH black = NULL;           // stock
+    COLORREF cachedColor = 0;      // g_Color the bucket colors were built for
+    bool cachedWhiten = true;      // and the whiten effect (quality governor)
+    bool cached = false;
+    HBRUSH brushes[BUCKETS] = {};  // GDI path
+    HPEN pens[BUCKETS] = {};       // GDI path, streaks
+    uint32_t glow[BUCKETS][256] = {}; // DIB path, premultiplied bucket colors
+    PolyBatch batch;               // GDI path
+    // incremental mode: what last frame drew (to erase) and what changed this frame
+    DamageBands prevStars;
+    DamageBands damage;
+    std::vector<uint32_t> readBack; // ReadFrame: the whole compatible bitmap, cropped to the frame
+    bool fullPresent = true;
+
+    explicit GdiRenderer(bool useDib) : dib(useDib) {}
+    ~GdiRenderer() { Release(); }
+    RenderPath Path() const override { return dib ? RENDER_DIB : RENDER_GDI; }
+    bool IsReady(const RenderWindow* rw) const override { return rw->backHdc != NULL && (wndDc != NULL || !rw->hwnd); }
+
+    bool Create(RenderWindow* rw) override
+    {
+        if (!CreateGdiBackbuffer(rw, dib)) return false;
+        // stock objects never need deselecting, so the pen stays in for the DC's life
+        SelectObject(rw->backHdc, GetStockObject(NULL_PEN));
+        SetPolyFillMode(rw->backHdc, WINDING);
+        black = (HBRUSH)GetStockObject(BLACK_BRUSH);
+        // new backbuffer starts black, the window contents are unknown
+        prevStars.Reset(rw->bitsW, rw->bitsH);
+        damage.Reset(rw->bitsW, rw->bitsH);
+        fullPresent = true;
+        if (!rw->hwnd) return true; // offscreen
+        if (!wndDc)
+        {
+            hwnd = rw->hwnd;
+            wndDc = GetDC(hwnd);
+        }
+        return wndDc != NULL;
+    }
+    void Destroy(RenderWindow* rw) override
+    {
+        DestroyGdiBackbuffer(rw);
+        Release();
+    }
+    void Release()
+    {
+        for (int b = 0; b < BUCKETS; ++b) if (brushes[b])
+        {
+            DeleteObject(brushes[b]); brushes[b] = NULL;
+        }
+        for (int b = 0; b < BUCKETS; ++b) if (pens[b])
+        {
+            DeleteObject(pens[b]); pens[b] = NULL;
+        }
+        cached = false;
+        if (wndDc) ReleaseDC(hwnd, wndDc);
+        wndDc = NULL;
+    }
+    // (re)build bucket colors / brushes, only when the star color changed
+    void UpdateCache(bool whiten)
+    {
+        if (cached && cachedColor == g_Color && cachedWhiten == whiten) return;
+        for (int b = 0; b < BUCKETS; ++b)
+        {
+            COLORREF c = BucketColor(b, BucketIntensity(b), whiten);
+            if (dib)
+            {
+                BuildGlowColors(c, glow[b]);
+                continue;
+            }
+            if (brushes[b]) DeleteObject(brushes[b]);
+            brushes[b] = CreateSolidBrush(c);
+            if (pens[b]) DeleteObject(pens[b]);
+            pens[b] = CreatePen(PS_SOLID, 1, c);
+        }
+        cachedColor = g_Color;
+        cachedWhiten = whiten;
+        cached = true;
+    }
+    void Draw(RenderWindow* rw) override
+    {
+        UpdateCache(rw->gov.Effects());
+        if (g_Incremental)
+        {
+            DrawIncremental(rw);
+            return;
+        }
+        fullPresent = true;
+        // still track what was drawn so switching to incremental erases it
+        prevStars.Reset(rw->bitsW, rw->bitsH);
+        // clear
+        if (rw->bits)
+        {
+            GdiFlush(); // GDI must be done with the section before we touch pixels
+            memset(rw->bits, 0, (size_t)rw->bitsStride * rw->bitsH * sizeof(uint32_t));
+        }
+        else
+        {
+            RECT fill = { 0, 0, rw->bitsW, rw->bitsH };
+            FillRect(rw->backHdc, &fill, black);
+        }
+        DrawStars(rw, &prevStars);
+    }
+    // erase only last frame's star bands, draw, and remember both for the present
+    void DrawIncremental(RenderWindow* rw)
+    {
+        if (rw->bits) GdiFlush();
+        prevStars.ForEachRect([&](int l, int t, int r, int b)
+        {
+            if (rw->bits)
+            {
+                for (int y = t; y < b; ++y) memset(rw->bits + (size_t)y * rw->bitsStride + l, 0, (size_t)(r - l) * sizeof(uint32_t));
+            }
+            else
+            {
+                RECT fill = { l, t, r, b };
+                FillRect(rw->backHdc, &fill, black);
+            }
+        });
+        std::swap(damage, prevStars);  // damage = what we just erased
+        prevStars.Reset(rw->bitsW, rw->bitsH);
+        DrawStars(rw, &prevStars);
+        damage.Merge(prevStars);       // ... plus what we drew
+    }
+    void DrawStars(RenderWindow* rw, DamageBands* dmg)
+    {
+        bool streaks = rw->proj.tails;
+        if (rw->bits)
+        {
+            if (streaks) DrawStreaksDib(rw, glow, dmg);
+            else DrawStarsDib(rw, glow, dmg);
+        }
+        else
+        {
+            if (streaks) DrawStreaksGdi(rw, brushes, pens, batch, dmg);
+            else DrawStarsGdi(rw, brushes, batch, dmg);
+        }
+    }
+    void DrawOverlay(RenderWindow* rw, const char* text) override
+    {
+        DrawHudText(rw->backHdc, text);
+        // erased with the stars next frame, presented with them this frame
+        const RECT& r = g_HudRect;
+        prevStars.Add(r.left, r.top, r.right, r.bottom);
+        damage.Add(r.left, r.top, r.right, r.bottom);
+    }
+    bool ReadFrame(RenderWindow* rw, uint32_t* dst, int w, int h) override
+    {
+        if (w > rw->bitsW || h > rw->bitsH) return false;
+        GdiFlush(); // batched GDI calls land in the bitmap first
+        if (rw->bits)
+        {
+            for (int y = 0; y < h; ++y) memcpy(dst + (size_t)y * w, rw->bits + (size_t)y * rw->bitsStride, (size_t)w * 4);
+            return true;
+        }
+        // compatible bitmap: GetDIBits converts whole rows of the allocated size and wants the
+        // bitmap out of the DC, the frame is cropped from that
+        int bw = rw->backW, bh = rw->backH;
+        readBack.resize((size_t)bw * bh);
+        BITMAPINFO bi = {};
+        bi.bmiHeader.biSize = sizeof(bi.bmiHeader);
+        bi.bmiHeader.biWidth = bw;
+        bi.bmiHeader.biHeight = -bh; // top-down
+        bi.bmiHeader.biPlanes = 1;
+        bi.bmiHeader.biBitCount = 32;
+        bi.bmiHeader.biCompression = BI_RGB;
+        SelectObject(rw->backHdc, rw->oldBackBmp);
+        int rows = GetDIBits(rw->backHdc, rw->backBmp, 0, bh, readBack.data(), &bi, DIB_RGB_COLORS);
+        SelectObject(rw->backHdc, rw->backBmp);
+        if (rows != bh) return false;
+        for (int y = 0; y < h; ++y) memcpy(dst + (size_t)y * w, readBack.data() + (size_t)y * bw, (size_t)w * 4);
+        return true;
+    }
+
+    void Present(RenderWindow* rw) override
+    {
+        if (!wndDc)
+        {
+            GdiFlush(); // offscreen: only finish the batched GDI calls
+            return;
+        }
+        // past about half the screen one big blit beats many small ones
+        if (fullPresent || damage.Area() * 2 > (long long)rw->bitsW * rw->bitsH)
+        {
+            BitBlt(wndDc, 0, 0, rw->bitsW, rw->bitsH, rw->backHdc, 0, 0, SRCCOPY);
+            fullPresent = false;
+            return;
+        }
+        damage.ForEachRect([&](int l, int t, int r, int b)
+        {
+            BitBlt(wndDc, l, t, r - l, b - t, rw->backHdc, l, t, SRCCOPY);
+        });
+    }
+};
+
+// D3D11: swap chain per window, rw->proj is uploaded to a dynamic instance buffer
+// and drawn as one instanced quad per star, textured from the glow sprite atlas and
+// blended additively. The atlas holds radii up to GLOW_ATLAS_R, larger stars stretch
+// the biggest sprite (bilinear), which only softens their one pixel edge.
+template <typename T> static void SafeRelease(T*& p)
+{
+    if (p) { p->Release(); p = nullptr; }
+}
+
+static const int GLOW_ATLAS_R = 32;
+static const int GLOW_ATLAS_W = 512;
+
+static const char* g_StarShader = R"(
+cbuffer Frame : register(b0)
+{
+    float2 toNdc;           // 2 / viewport
+    float2 pad;
+    float4 colors[BUCKETS];
+};
+cbuffer Atlas : register(b1)
+{
+    float4 sprites[GLOW_ATLAS_R + 1]; // uv rect (u0, v0, du, dv) per radius
+};
+Texture2D<float> glow : register(t0);
+SamplerState linearClamp : register(s0);
+struct VSIn
+{
+    float2 corner : POSITION;  // -1..1 quad corner
+    float4 star : STAR;        // px, py, psz, bucket
+};
+struct VSOut
+{
+    float4 pos : SV_Position;
+    float2 uv : TEXCOORD0;
+    float4 color : COLOR0;
+};
+VSOut VSMain(VSIn i)
+{
+    VSOut o;
+    float r = i.star.z;
+    float e = r + floor(r * 0.5) + 1.0; // GlowExtent
+    float2 p = i.star.xy + i.corner * (e + 0.5);
+    o.pos = float4(p.x * toNdc.x - 1.0, 1.0 - p.y * toNdc.y, 0.0, 1.0);
+    float4 rect = sprites[min((uint)r, (uint)GLOW_ATLAS_R)];
+    o.uv = rect.xy + (i.corner * 0.5 + 0.5) * rect.zw;
+    o.color = colors[(uint)i.star.w];
+    return o;
+}
+float4 PSMain(VSOut i) : SV_Target
+{
+    return float4(i.color.rgb * glow.Sample(linearClamp, i.uv), 1.0);
+}
+// streaks: line list, tail and head vertex per star (px, py, bucket)
+struct LineOut
+{
+    float4 pos : SV_Position;
+    float4 color : COLOR0;
+};
+LineOut VSLine(float3 v : LINE)
+{
+    LineOut o;
+    o.pos = float4(v.x * toNdc.x - 1.0, 1.0 - v.y * toNdc.y, 0.0, 1.0);
+    o.color = colors[(uint)v.z];
+    return o;
+}
+// the AA line rasterizer puts coverage in alpha, blended as src * alpha + dst
+float4 PSLine(LineOut i) : SV_Target
+{
+    return float4(i.color.rgb, 1.0);
+}
+)";
+
+static const D3D_FEATURE_LEVEL g_D3DLevels[] = { D3D_FEATURE_LEVEL_11_0, D3D_FEATURE_LEVEL_10_1, D3D_FEATURE_LEVEL_10_0 };
+
+struct D3D11Renderer : StarRenderer
+{
+    // per-instance vertex: matches the STAR input element
+    struct Instance { float px, py, psz, bucket; };
+    // matches cbuffer Frame
+    struct FrameConstants { float toNdc[2]; float pad[2]; float colors[BUCKETS][4]; };
+    // matches the LINE input element
+    struct LineVertex { float x, y, bucket; };
+
+    ID3D11Device* device = nullptr;
+    ID3D11DeviceContext* ctx = nullptr;
+    IDXGISwapChain* swap = nullptr;
+    ID3D11RenderTargetView* rtv = nullptr;
+    ID3D11VertexShader* vs = nullptr;
+    ID3D11PixelShader* ps = nullptr;
+    ID3D11InputLayout* layout = nullptr;
+    ID3D11Buffer* quad = nullptr;
+    ID3D11Buffer* instances = nullptr;
+    ID3D11Buffer* constants = nullptr;
+    ID3D11Buffer* atlasRects = nullptr;
+    ID3D11ShaderResourceView* atlas = nullptr;
+    ID3D11SamplerState* sampler = nullptr;
+    ID3D11BlendState* additive = nullptr;
+    ID3D11Texture2D* offscreen = nullptr; // target without a window
+    ID3D11Query* done = nullptr;          // offscreen Present waits on it
+    ID3D11Texture2D* staging = nullptr;   // ReadFrame copy the CPU can map
+    IDXGIOutput* output = nullptr;        // monitor the swap chain is on, for WaitForVBlank
+    // streaks
+    ID3D11VertexShader* lineVs = nullptr;
+    ID3D11PixelShader* linePs = nullptr;
+    ID3D11InputLayout* lineLayout = nullptr;
+    ID3D11RasterizerState* lineRaster = nullptr; // antialiased lines
+    ID3D11BlendState* lineBlend = nullptr;       // additive, weighted by coverage
+    ID3D11Buffer* lines = nullptr;
+    int lineCapacity = 0; // lines buffer size in vertices
+    int capacity = 0; // instances buffer size in stars
+    int width = 0;
+    int height = 0;
+    UINT swapFlags = 0; // GDI compatible when the HUD is on
+
+    ~D3D11Renderer() { Release(); }
+    RenderPath Path() const override { return RENDER_D3D11; }
+    bool IsReady(const RenderWindow*) const override { return rtv != nullptr; }
+
+    bool Create(RenderWindow* rw) override
+    {
+        int w = max(1, rw->rc.right - rw->rc.left);
+        int h = max(1, rw->rc.bottom - rw->rc.top);
+        if (!rw->hwnd) return CreateOffscreen(w, h);
+        if (swap)
+        {
+            // resize keeps the device and pipeline
+            if (w == width && h == height && rtv) return true;
+            SafeRelease(rtv);
+            if (FAILED(swap->ResizeBuffers(0, w, h, DXGI_FORMAT_UNKNOWN, swapFlags)) || !CreateTarget())
+            {
+                Release();
+                return false;
+            }
+            width = w;
+            height = h;
+            return true;
+        }
+        DXGI_SWAP_CHAIN_DESC sd = {};
+        sd.BufferDesc.Width = w;
+        sd.BufferDesc.Height = h;
+        sd.BufferDesc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+        sd.SampleDesc.Count = 1;
+        sd.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+        sd.BufferCount = 2;
+        sd.OutputWindow = rw->hwnd;
+        sd.Windowed = TRUE;
+        sd.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
+        swapFlags = g_ShowHud ? DXGI_SWAP_CHAIN_FLAG_GDI_COMPATIBLE : 0;
+        sd.Flags = swapFlags;
+        HRESULT hr = D3D11CreateDeviceAndSwapChain(NULL, D3D_DRIVER_TYPE_HARDWARE, NULL, 0, g_D3DLevels, 3,
+            D3D11_SDK_VERSION, &sd, &swap, &device, NULL, &ctx);
+        if (FAILED(hr) || !CreateTarget() || !CreatePipeline())
+        {
+            Release();
+            return false;
+        }
+        width = w;
+        height = h;
+        return true;
+    }
+
+    // benchmark: render into a texture, Present waits for the GPU instead of flipping
+    bool CreateOffscreen(int w, int h)
+    {
+        if (device && w == width && h == height && rtv) return true;
+        SafeRelease(rtv);
+        SafeRelease(offscreen);
+        if (!device)
+        {
+            HRESULT hr = D3D11CreateDevice(NULL, D3D_DRIVER_TYPE_HARDWARE, NULL, 0, g_D3DLevels, 3,
+                D3D11_SDK_VERSION, &device, NULL, &ctx);
+            D3D11_QUERY_DESC qd = { D3D11_QUERY_EVENT, 0 };
+            if (FAILED(hr) || !CreatePipeline() || FAILED(device->CreateQuery(&qd, &done)))
+            {
+                Release();
+                return false;
+            }
+        }
+        D3D11_TEXTURE2D_DESC td = {};
+        td.Width = w;
+        td.Height = h;
+        td.MipLevels = 1;
+        td.ArraySize = 1;
+        td.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+        td.SampleDesc.Count = 1;
+        td.Usage = D3D11_USAGE_DEFAULT;
+        td.BindFlags = D3D11_BIND_RENDER_TARGET;
+        if (FAILED(device->CreateTexture2D(&td, NULL, &offscreen)) || FAILED(device->CreateRenderTargetView(offscreen, NULL, &rtv)))
+        {
+            Release();
+            return false;
+        }
+        width = w;
+        height = h;
+        return true;
+    }
+
+    void Destroy(RenderWindow*) override { Release(); }
+
+    void Release()
+    {
+        SafeRelease(lines);
+        SafeRelease(lineBlend);
+        SafeRelease(lineRaster);
+        SafeRelease(lineLayout);
+        SafeRelease(linePs);
+        SafeRelease(lineVs);
+        SafeRelease(additive);
+        SafeRelease(sampler);
+        SafeRelease(atlas);
+        SafeRelease(atlasRects);
+        SafeRelease(constants);
+        SafeRelease(instances);
+        SafeRelease(quad);
+        SafeRelease(layout);
+        SafeRelease(ps);
+        SafeRelease(vs);
+        SafeRelease(rtv);
+        SafeRelease(offscreen);
+        SafeRelease(staging);
+        SafeRelease(done);
+        SafeRelease(output);
+        if (ctx)
+        {
+            // flush so DXGI really lets go of the window before a new swap chain
+            ctx->ClearState();
+            ctx->Flush();
+        }
+        SafeRelease(ctx);
+        SafeRelease(swap);
+        SafeRelease(device);
+        capacity = 0;
+        lineCapacity = 0;
+        width = height = 0;
+    }
+
+    bool CreateTarget()
+    {
+        ID3D11Texture2D* back = nullptr;
+        if (FAILED(swap->GetBuffer(0, __uuidof(ID3D11Texture2D), (void**)&back))) return false;
+        HRESULT hr = device->CreateRenderTargetView(back, NULL, &rtv);
+        back->Release();
+        return SUCCEEDED(hr);
+    }
+
+    bool CreatePipeline()
+    {
+        char buckets[8], atlasR[8];
+        sprintf_s(buckets, "%d", BUCKETS);
+        sprintf_s(atlasR, "%d", GLOW_ATLAS_R);
+        const D3D_SHADER_MACRO defines[] = { { "BUCKETS", buckets }, { "GLOW_ATLAS_R", atlasR }, { NULL, NULL } };
+        ID3DBlob* vsCode = nullptr;
+        ID3DBlob* psCode = nullptr;
+        size_t len = strlen(g_StarShader);
+        bool ok = SUCCEEDED(D3DCompile(g_StarShader, len, "stars", defines, NULL, "VSMain", "vs_4_0", D3DCOMPILE_OPTIMIZATION_LEVEL3, 0, &vsCode, NULL))
+            && SUCCEEDED(D3DCompile(g_StarShader, len, "stars", defines, NULL, "PSMain", "ps_4_0", D3DCOMPILE_OPTIMIZATION_LEVEL3, 0, &psCode, NULL))
+            && SUCCEEDED(device->CreateVertexShader(vsCode->GetBufferPointer(), vsCode->GetBufferSize(), NULL, &vs))
+            && SUCCEEDED(device->CreatePixelShader(psCode->GetBufferPointer(), psCode->GetBufferSize(), NULL, &ps));
+        if (ok)
+        {
+            const D3D11_INPUT_ELEMENT_DESC elems[] =
+            {
+                { "POSITION", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+                { "STAR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 0, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+            };
+            ok = SUCCEEDED(device->CreateInputLayout(elems, 2, vsCode->GetBufferPointer(), vsCode->GetBufferSize(), &layout));
+        }
+        SafeRelease(vsCode);
+        SafeRelease(psCode);
+        if (!ok) return false;
+
+        // unit quad as a 4 vertex strip
+        const float corners[8] = { -1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f };
+        D3D11_BUFFER_DESC bd = {};
+        bd.ByteWidth = sizeof(corners);
+        bd.Usage = D3D11_USAGE_IMMUTABLE;
+        bd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+        D3D11_SUBRESOURCE_DATA init = {};
+        init.pSysMem = corners;
+        if (FAILED(device->CreateBuffer(&bd, &init, &quad))) return false;
+
+        D3D11_BUFFER_DESC cd = {};
+        cd.ByteWidth = sizeof(FrameConstants);
+        cd.Usage = D3D11_USAGE_DEFAULT;
+        cd.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+        if (FAILED(device->CreateBuffer(&cd, NULL, &constants))) return false;
+
+        D3D11_BLEND_DESC bl = {};
+        bl.RenderTarget[0].BlendEnable = TRUE;
+        bl.RenderTarget[0].SrcBlend = D3D11_BLEND_ONE;
+        bl.RenderTarget[0].DestBlend = D3D11_BLEND_ONE;
+        bl.RenderTarget[0].BlendOp = D3D11_BLEND_OP_ADD;
+        bl.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE;
+        bl.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ZERO;
+        bl.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+        bl.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+        if (FAILED(device->CreateBlendState(&bl, &additive))) return false;
+
+        D3D11_SAMPLER_DESC sm = {};
+        sm.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+        sm.AddressU = sm.AddressV = sm.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+        sm.MaxLOD = D3D11_FLOAT32_MAX;
+        if (FAILED(device->CreateSamplerState(&sm, &sampler))) return false;
+        return CreateAtlas() && CreateLinePipeline(defines);
+    }
+
+    bool CreateLinePipeline(const D3D_SHADER_MACRO* defines)
+    {
+        ID3DBlob* vsCode = nullptr;
+        ID3DBlob* psCode = nullptr;
+        size_t len = strlen(g_StarShader);
+        bool ok = SUCCEEDED(D3DCompile(g_StarShader, len, "stars", defines, NULL, "VSLine", "vs_4_0", D3DCOMPILE_OPTIMIZATION_LEVEL3, 0, &vsCode, NULL))
+            && SUCCEEDED(D3DCompile(g_StarShader, len, "stars", defines, NULL, "PSLine", "ps_4_0", D3DCOMPILE_OPTIMIZATION_LEVEL3, 0, &psCode, NULL))
+            && SUCCEEDED(device->CreateVertexShader(vsCode->GetBufferPointer(), vsCode->GetBufferSize(), NULL, &lineVs))
+            && SUCCEEDED(device->CreatePixelShader(psCode->GetBufferPointer(), psCode->GetBufferSize(), NULL, &linePs));
+        if (ok)
+        {
+            const D3D11_INPUT_ELEMENT_DESC elem = { "LINE", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 };
+            ok = SUCCEEDED(device->CreateInputLayout(&elem, 1, vsCode->GetBufferPointer(), vsCode->GetBufferSize(), &lineLayout));
+        }
+        SafeRelease(vsCode);
+        SafeRelease(psCode);
+        if (!ok) return false;
+
+        D3D11_RASTERIZER_DESC rd = {};
+        rd.FillMode = D3D11_FILL_SOLID;
+        rd.CullMode = D3D11_CULL_NONE;
+        rd.DepthClipEnable = TRUE;
+        rd.AntialiasedLineEnable = TRUE;
+        if (FAILED(device->CreateRasterizerState(&rd, &lineRaster))) return false;
+
+        D3D11_BLEND_DESC bl = {};
+        bl.RenderTarget[0].BlendEnable = TRUE;
+        bl.RenderTarget[0].SrcBlend = D3D11_BLEND_SRC_ALPHA;
+        bl.RenderTarget[0].DestBlend = D3D11_BLEND_ONE;
+        bl.RenderTarget[0].BlendOp = D3D11_BLEND_OP_ADD;
+        bl.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE;
+        bl.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ZERO;
+        bl.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+        bl.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+        return SUCCEEDED(device->CreateBlendState(&bl, &lineBlend));
+    }
+
+    // glow sprites for radius 1..GLOW_ATLAS_R on shelves, one texel of gutter around each
+    bool CreateAtlas()
+    {
+        float rects[GLOW_ATLAS_R + 1][4] = {};
+        int x = 1, y = 1, shelf = 0;
+        int pos[GLOW_ATLAS_R + 1][2] = {};
+        for (int r = 1; r <= GLOW_ATLAS_R; ++r)
+        {
+            int size = 2 * GlowExtent(r) + 1;
+            if (x + size + 1 > GLOW_ATLAS_W)
+            {
+                x = 1;
+                y += shelf + 1;
+                shelf = 0;
+            }
+            pos[r][0] = x;
+            pos[r][1] = y;
+            x += size + 1;
+            shelf = max(shelf, size);
+        }
+        int atlasH = y + shelf + 1;
+        std::vector<uint8_t> texels((size_t)GLOW_ATLAS_W * atlasH, 0);
+        for (int r = 1; r <= GLOW_ATLAS_R; ++r)
+        {
+            int size = 2 * GlowExtent(r) + 1;
+            const uint8_t* sprite = GlowSprite(r);
+            for (int row = 0; row < size; ++row)
+                memcpy(&texels[(size_t)(pos[r][1] + row) * GLOW_ATLAS_W + pos[r][0]], sprite + (size_t)row * size, size);
+            rects[r][0] = pos[r][0] / (float)GLOW_ATLAS_W;
+            rects[r][1] = pos[r][1] / (float)atlasH;
+            rects[r][2] = size / (float)GLOW_ATLAS_W;
+            rects[r][3] = size / (float)atlasH;
+        }
+
+        D3D11_TEXTURE2D_DESC td = {};
+        td.Width = GLOW_ATLAS_W;
+        td.Height = atlasH;
+        td.MipLevels = 1;
+        td.ArraySize = 1;
+        td.Format = DXGI_FORMAT_R8_UNORM;
+        td.SampleDesc.Count = 1;
+        td.Usage = D3D11_USAGE_IMMUTABLE;
+        td.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+        D3D11_SUBRESOURCE_DATA init = {};
+        init.pSysMem = texels.data();
+        init.SysMemPitch = GLOW_ATLAS_W;
+        ID3D11Texture2D* tex = nullptr;
+        if (FAILED(device->CreateTexture2D(&td, &init, &tex))) return false;
+        HRESULT hr = device->CreateShaderResourceView(tex, NULL, &atlas);
+        tex->Release();
+        if (FAILED(hr)) return false;
+
+        D3D11_BUFFER_DESC bd = {};
+        bd.ByteWidth = sizeof(rects);
+        bd.Usage = D3D11_USAGE_IMMUTABLE;
+        bd.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+        D3D11_SUBRESOURCE_DATA rinit = {};
+        rinit.pSysMem = rects;
+        return SUCCEEDED(device->CreateBuffer(&bd, &rinit, &atlasRects));
+    }
+
+    // grow the dynamic line buffer to hold n vertices
+    bool EnsureLineCapacity(int n)
+    {
+        if (n <= lineCapacity && lines) return true;
+        SafeRelease(lines);
+        lineCapacity = max(n, lineCapacity + lineCapacity / 2);
+        D3D11_BUFFER_DESC bd = {};
+        bd.ByteWidth = (UINT)(lineCapacity * sizeof(LineVertex));
+        bd.Usage = D3D11_USAGE_DYNAMIC;
+        bd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+        bd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+        if (SUCCEEDED(device->CreateBuffer(&bd, NULL, &lines))) return true;
+        lineCapacity = 0;
+        return false;
+    }
+
+    // grow the dynamic instance buffer to hold n stars
+    bool EnsureCapacity(int n)
+    {
+        if (n <= capacity && instances) return true;
+        SafeRelease(instances);
+        capacity = max(n, capacity + capacity / 2);
+        D3D11_BUFFER_DESC bd = {};
+        bd.ByteWidth = (UINT)(capacity * sizeof(Instance));
+        bd.Usage = D3D11_USAGE_DYNAMIC;
+        bd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+        bd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+        if (SUCCEEDED(device->CreateBuffer(&bd, NULL, &instances))) return true;
+        capacity = 0;
+        return false;
+    }
+
+    void Draw(RenderWindow* rw) override
+    {
+        const ProjectedStars& pst = rw->proj;
+        const float black[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+        // flip model unbinds the target after every Present
+        ctx->OMSetRenderTargets(1, &rtv, NULL);
+        ctx->ClearRenderTargetView(rtv, black);
+        if (pst.count == 0 || !EnsureCapacity(pst.count)) return;
+
+        D3D11_MAPPED_SUBRESOURCE m;
+        if (FAILED(ctx->Map(instances, 0, D3D11_MAP_WRITE_DISCARD, 0, &m))) return;
+        // draw list order: far buckets first, one instanced draw for all of them
+        // (streaks: only the heads of the big ones, the lines carry the rest)
+        Instance* dst = (Instance*)m.pData;
+        const DrawList& dl = rw->drawList;
+        int minPsz = pst.tails ? STREAK_HEAD_PSZ : 0;
+        int heads = 0;
+        for (int k = 0; k < pst.count; ++k)
+        {
+            int i = dl.order[k];
+            if (pst.psz[i] <= minPsz) continue;
+            dst[heads].px = pst.px[i];
+            dst[heads].py = pst.py[i];
+            dst[heads].psz = (float)pst.psz[i];
+            dst[heads].bucket = (float)pst.bucket[i];
+            ++heads;
+        }
+        ctx->Unmap(instances, 0);
+        rw->lodCounts[2] = heads; // the GPU draws every star as a sprite
+
+        FrameConstants fc = {};
+        fc.toNdc[0] = 2.0f / (float)width;
+        fc.toNdc[1] = 2.0f / (float)height;
+        for (int b = 0; b < BUCKETS; ++b)
+        {
+            COLORREF c = BucketColor(b, BucketIntensity(b), rw->gov.Effects());
+            fc.colors[b][0] = GetRValue(c) / 255.0f;
+            fc.colors[b][1] = GetGValue(c) / 255.0f;
+            fc.colors[b][2] = GetBValue(c) / 255.0f;
+            fc.colors[b][3] = 1.0f;
+        }
+        ctx->UpdateSubresource(constants, 0, NULL, &fc, 0, 0);
+
+        D3D11_VIEWPORT vp = { 0.0f, 0.0f, (float)width, (float)height, 0.0f, 1.0f };
+        ctx->RSSetViewports(1, &vp);
+        if (pst.tails) DrawLines(rw);
+        if (heads == 0) return;
+        ID3D11Buffer* vbs[2] = { quad, instances };
+        UINT strides[2] = { 2 * sizeof(float), sizeof(Instance) };
+        UINT offsets[2] = { 0, 0 };
+        ctx->IASetVertexBuffers(0, 2, vbs, strides, offsets);
+        ctx->IASetInputLayout(layout);
+        ctx->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+        ctx->VSSetShader(vs, NULL, 0);
+        ID3D11Buffer* cbs[2] = { constants, atlasRects };
+        ctx->VSSetConstantBuffers(0, 2, cbs);
+        ctx->PSSetShader(ps, NULL, 0);
+        ctx->PSSetShaderResources(0, 1, &atlas);
+        ctx->PSSetSamplers(0, 1, &sampler);
+        ctx->OMSetBlendState(additive, NULL, 0xffffffff);
+        ctx->DrawInstanced(4, heads, 0, 0);
+    }
+
+    // streaks: one line list draw, tail to head per star; constants are already up
+    void DrawLines(RenderWindow* rw)
+    {
+        const ProjectedStars& pst = rw->proj;
+        if (!EnsureLineCapacity(2 * pst.count)) return;
+        D3D11_MAPPED_SUBRESOURCE m;
+        if (FAILED(ctx->Map(lines, 0, D3D11_MAP_WRITE_DISCARD, 0, &m))) return;
+        LineVertex* v = (LineVertex*)m.pData;
+        const DrawList& dl = rw->drawList;
+        for (int k = 0; k < pst.count; ++k)
+        {
+            int i = dl.order[k];
+            float b = (float)pst.bucket[i];
+            v[2 * k] = { pst.tx[i], pst.ty[i], b };
+            v[2 * k + 1] = { pst.px[i], pst.py[i], b };
+        }
+        ctx->Unmap(lines, 0);
+        UINT stride = sizeof(LineVertex), offset = 0;
+        ctx->IASetVertexBuffers(0, 1, &lines, &stride, &offset);
+        ctx->IASetInputLayout(lineLayout);
+        ctx->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_LINELIST);
+        ctx->VSSetShader(lineVs, NULL, 0);
+        ctx->VSSetConstantBuffers(0, 1, &constants);
+        ctx->PSSetShader(linePs, NULL, 0);
+        ctx->RSSetState(lineRaster);
+        ctx->OMSetBlendState(lineBlend, NULL, 0xffffffff);
+        ctx->Draw(2 * pst.count, 0);
+        ctx->RSSetState(NULL);
+    }
+
+    // GDI text straight onto the back buffer
+    void DrawOverlay(RenderWindow*, const char* text) override
+    {
+        if (!(swapFlags & DXGI_SWAP_CHAIN_FLAG_GDI_COMPATIBLE)) return;
+        IDXGISurface1* surf = nullptr;
+        if (FAILED(swap->GetBuffer(0, __uuidof(IDXGISurface1), (void**)&surf))) return;
+        ctx->OMSetRenderTargets(0, NULL, NULL); // GetDC needs the target unbound
+        HDC hdc = NULL;
+        if (SUCCEEDED(surf->GetDC(FALSE, &hdc)))
+        {
+            DrawHudText(hdc, text);
+            surf->ReleaseDC(NULL);
+        }
+        surf->Release();
+    }
+
+    void Present(RenderWindow*) override
+    {
+        if (!swap)
+        {
+            // offscreen: the frame counts once the GPU is done with it
+            ctx->End(done);
+            while (ctx->GetData(done, NULL, 0, 0) == S_FALSE) YieldProcessor();
+            return;
+        }
+        HRESULT hr = swap->Present(0, 0);
+        // lost device (driver update, TDR): drop everything, RenderFrame rebuilds it
+        if (hr == DXGI_ERROR_DEVICE_REMOVED || hr == DXGI_ERROR_DEVICE_RESET) Release();
+    }
+
+    // The map waits for the GPU to finish the frame, so a capture costs one sync per frame
+    bool ReadFrame(RenderWindow*, uint32_t* dst, int w, int h) override
+    {
+        if (!rtv || w > width || h > height) return false;
+        ID3D11Texture2D* target = offscreen;
+        if (swap && FAILED(swap->GetBuffer(0, __uuidof(ID3D11Texture2D), (void**)&target))) return false;
+        D3D11_TEXTURE2D_DESC td;
+        target->GetDesc(&td);
+        if (staging)
+        {
+            D3D11_TEXTURE2D_DESC sd;
+            staging->GetDesc(&sd);
+            if (sd.Width != td.Width || sd.Height != td.Height) SafeRelease(staging);
+        }
+        if (!staging)
+        {
+            td.Usage = D3D11_USAGE_STAGING;
+            td.BindFlags = 0;
+            td.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+            td.MiscFlags = 0;
+            device->CreateTexture2D(&td, NULL, &staging);
+        }
+        bool ok = false;
+        D3D11_MAPPED_SUBRESOURCE m;
+        if (staging)
+        {
+            ctx->CopyResource(staging, target);
+            ok = SUCCEEDED(ctx->Map(staging, 0, D3D11_MAP_READ, 0, &m));
+        }
+        if (swap) target->Release();
+        if (!ok) return false;
+        for (int y = 0; y < h; ++y) memcpy(dst + (size_t)y * w, (const BYTE*)m.pData + (size_t)y * m.RowPitch, (size_t)w * 4);
+        ctx->Unmap(staging, 0);
+        return true;
+    }
+
+    bool WaitForVBlank() override
+    {
+        if (!swap) return false;
+        if (!output && FAILED(swap->GetContainingOutput(&output))) return false;
+        return SUCCEEDED(output->WaitForVBlank());
+    }
+};
+
+static StarRenderer* MakeRenderer(RenderPath path)
+{
+    if (path == RENDER_D3D11) return new D3D11Renderer();
+    return new GdiRenderer(path == RENDER_DIB);
+}
+
+// ---- backbuffer: whichever renderer the window uses, falling back
+// D3D11 -> DIB -> GDI when a backend cannot be created on this machine / session.
+static bool CreateBackbuffer(RenderWindow* rw)
+{
+    if (!rw || !rw->hwnd) return false;
+    if (!rw->renderer) rw->renderer.reset(MakeRenderer(g_RenderPath));
+    for (;;)
+    {
+        if (rw->renderer->Create(rw)) return true;
+        RenderPath path = rw->renderer->Path();
+        if (path == RENDER_GDI) return false;
+        rw->renderer.reset(MakeRenderer(path == RENDER_D3D11 ? RENDER_DIB : RENDER_GDI));
+    }
+}
+
+static void DestroyBackbuffer(RenderWindow* rw)
+{
+    if (!rw || !rw->renderer) return;
+    rw->renderer->Destroy(rw);
+}
+
+// Shared field: this window's part of the desktop, from its current rect (worker or startup)
+static void UpdateSharedSlice(RenderWindow* rw)
+{
+    SharedSlice sl = { (float)(rw->desktopPos.x - g_Shared.rc.left), (float)(rw->desktopPos.y - g_Shared.rc.top),
+        (float)max(1, rw->rc.right - rw->rc.left), (float)max(1, rw->rc.bottom - rw->rc.top), rw->dpi };
+    std::lock_guard<std::mutex> lk(g_Shared.frameMutex);
+    if (rw->index >= (int)g_Shared.slices.size()) g_Shared.slices.resize(rw->index + 1);
+    g_Shared.slices[rw->index] = sl;
+}
+
+// RenderFrame tuned to the sample values (uses totalTime)
+static void RenderFrame(RenderWindow* rw, float dt, double totalTime)
+{
+    if (!rw || !rw->renderer) return;
+    if (!rw->renderer->IsReady(rw) && !CreateBackbuffer(rw)) return;
+    int w = max(1, rw->rc.right - rw->rc.left);
+    int h = max(1, rw->rc.bottom - rw->rc.top);
+
+    // simulate first, the draw pass only sees compact screen-space output
+    {
+        ScopedTimer t(rw->stats, PHASE_SIMULATE);
+        if (rw->field) SimulateShared(rw, dt, totalTime);
+        else SimulateStars(rw, MakeSimParams(w, h, dt, totalTime, rw->fieldSpeed, rw->isPreview ? PROFILE_PREVIEW : PROFILE_FULLSCREEN,
+            rw->dpi / 96.0f, rw->gov.Effects()));
+    }
+    ScopedTimer t(rw->stats, PHASE_DRAW);
+    BuildDrawList(rw->proj, rw->drawList);
+    memset(rw->lodCounts, 0, sizeof(rw->lodCounts));
+    rw->renderer->Draw(rw);
+    if (g_ShowHud && rw->hudText[0]) rw->renderer->DrawOverlay(rw, rw->hudText);
+}
+
+// Show the finished frame
+static void PresentFrame(RenderWindow* rw)
+{
+    if (!rw || !rw->renderer || !rw->renderer->IsReady(rw)) return;
+    ScopedTimer t(rw->stats, PHASE_PRESENT);
+    rw->renderer->Present(rw);
+}
+
+// ---- Capture: drawn frames are copied into a ring of preallocated buffers and encoded on
+// a thread of its own, to an H.264 .mp4 (Media Foundation) or a PNG sequence (WIC).
+// "/v[:frames]" renders offline at a fixed dt and waits for a free slot (backpressure),
+// "/s /capture" records the primary monitor while the saver runs and drops frames instead.
+static const int CAPTURE_RING = 4;
+static const int CAPTURE_DEFAULT_FRAMES = 600;
+static const UINT CAPTURE_BITRATE = 20000000; // bits per second
+
+struct CaptureEncoder
+{
+    virtual ~CaptureEncoder() {}
+    // base is the output path without extension
+    virtual bool Open(const wchar_t* base, int w, int h, int fps) = 0;
+    // top-down BGRX rows, time in 100 ns units since the first frame
+    virtual bool Write(const uint32_t* pixels, int frame, LONGLONG time) = 0;
+    virtual void Close() = 0;
+};
+
+// base_00000.png, base_00001.png, ... as 24 bit, PNG has no use for the X byte
+struct PngSequenceEncoder : CaptureEncoder
+{
+    IWICImagingFactory* factory = nullptr;
+    std::wstring base;
+    int width = 0;
+    int height = 0;
+    std::vector<BYTE> row;
+
+    ~PngSequenceEncoder() { Close(); }
+
+    bool Open(const wchar_t* path, int w, int h, int) override
+    {
+        base = path;
+        width = w;
+        height = h;
+        row.resize((size_t)w * 3);
+        return SUCCEEDED(CoCreateInstance(CLSID_WICImagingFactory, NULL, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&factory)));
+    }
+
+    bool Write(const uint32_t* pixels, int frame, LONGLONG) override
+    {
+        wchar_t name[MAX_PATH];
+        swprintf_s(name, L"%s_%05d.png", base.c_str(), frame);
+        IWICStream* stream = nullptr;
+        IWICBitmapEncoder* enc = nullptr;
+        IWICBitmapFrameEncode* bmp = nullptr;
+        IPropertyBag2* props = nullptr;
+        WICPixelFormatGUID fmt = GUID_WICPixelFormat24bppBGR;
+        bool ok = SUCCEEDED(factory->CreateStream(&stream)) && SUCCEEDED(stream->InitializeFromFilename(name, GENERIC_WRITE)) &&
+            SUCCEEDED(factory->CreateEncoder(GUID_ContainerFormatPng, NULL, &enc)) && SUCCEEDED(enc->Initialize(stream, WICBitmapEncoderNoCache)) &&
+            SUCCEEDED(enc->CreateNewFrame(&bmp, &props)) && SUCCEEDED(bmp->Initialize(props)) &&
+            SUCCEEDED(bmp->SetSize(width, height)) && SUCCEEDED(bmp->SetPixelFormat(&fmt)) && fmt == GUID_WICPixelFormat24bppBGR;
+        for (int y = 0; ok && y < height; ++y)
+        {
+            const uint32_t* src = pixels + (size_t)y * width;
+            for (int x = 0; x < width; ++x)
+            {
+                row[x * 3 + 0] = (BYTE)src[x];
+                row[x * 3 + 1] = (BYTE)(src[x] >> 8);
+                row[x * 3 + 2] = (BYTE)(src[x] >> 16);
+            }
+            ok = SUCCEEDED(bmp->WritePixels(1, width * 3, (UINT)row.size(), row.data()));
+        }
+        ok = ok && SUCCEEDED(bmp->Commit()) && SUCCEEDED(enc->Commit());
+        SafeRelease(props);
+        SafeRelease(bmp);
+        SafeRelease(enc);
+        SafeRelease(stream);
+        return ok;
+    }
+
+    void Close() override { SafeRelease(factory); }
+};
+
+// base.mp4 through the sink writer, which picks the H.264 encoder MFT (hardware if any)
+struct Mp4Encoder : CaptureEncoder
+{
+    IMFSinkWriter* writer = nullptr;
+    DWORD stream = 0;
+    int width = 0;
+    int height = 0;
+    LONGLONG frameTime = 0; // 100 ns at the nominal rate
+    bool started = false;   // MFStartup
+
+    ~Mp4Encoder() { Close(); }
+
+    bool SetVideoType(IMFMediaType* t, REFGUID subtype, int fps)
+    {
+        return SUCCEEDED(t->SetGUID(MF_MT_MAJOR_TYPE, MFMediaType_Video)) && SUCCEEDED(t->SetGUID(MF_MT_SUBTYPE, subtype)) &&
+            SUCCEEDED(t->SetUINT32(MF_MT_INTERLACE_MODE, MFVideoInterlace_Progressive)) &&
+            SUCCEEDED(MFSetAttributeSize(t, MF_MT_FRAME_SIZE, width, height)) &&
+            SUCCEEDED(MFSetAttributeRatio(t, MF_MT_FRAME_RATE, fps, 1)) &&
+            SUCCEEDED(MFSetAttributeRatio(t, MF_MT_PIXEL_ASPECT_RATIO, 1, 1));
+    }
+
+    bool Open(const wchar_t* base, int w, int h, int fps) override
+    {
+        width = w;
+        height = h;
+        frameTime = 10000000LL / max(1, fps);
+        if (FAILED(MFStartup(MF_VERSION, MFSTARTUP_LITE))) return false;
+        started = true;
+        wchar_t name[MAX_PATH];
+        swprintf_s(name, L"%s.mp4", base);
+        IMFMediaType* out = nullptr;
+        IMFMediaType* in = nullptr;
+        bool ok = SUCCEEDED(MFCreateSinkWriterFromURL(name, NULL, NULL, &writer)) &&
+            SUCCEEDED(MFCreateMediaType(&out)) && SetVideoType(out, MFVideoFormat_H264, fps) &&
+            SUCCEEDED(out->SetUINT32(MF_MT_AVG_BITRATE, CAPTURE_BITRATE)) && SUCCEEDED(writer->AddStream(out, &stream)) &&
+            SUCCEEDED(MFCreateMediaType(&in)) && SetVideoType(in, MFVideoFormat_RGB32, fps) &&
+            // positive stride: top-down rows as the renderers hand them over
+            SUCCEEDED(in->SetUINT32(MF_MT_DEFAULT_STRIDE, (UINT)(w * 4))) &&
+            SUCCEEDED(writer->SetInputMediaType(stream, in, NULL)) && SUCCEEDED(writer->BeginWriting());
+        SafeRelease(out);
+        SafeRelease(in);
+        return ok;
+    }
+
+    bool Write(const uint32_t* pixels, int, LONGLONG time) override
+    {
+        DWORD size = (DWORD)width * height * 4;
+        IMFMediaBuffer* buf = nullptr;
+        IMFSample* sample = nullptr;
+        BYTE* dst = nullptr;
+        bool ok = SUCCEEDED(MFCreateMemoryBuffer(size, &buf)) && SUCCEEDED(buf->Lock(&dst, NULL, NULL));
+        if (ok)
+        {
+            MFCopyImage(dst, width * 4, (const BYTE*)pixels, width * 4, width * 4, height);
+            buf->Unlock();
+            ok = SUCCEEDED(buf->SetCurrentLength(size)) && SUCCEEDED(MFCreateSample(&sample)) && SUCCEEDED(sample->AddBuffer(buf)) &&
+                SUCCEEDED(sample->SetSampleTime(time)) && SUCCEEDED(sample->SetSampleDuration(frameTime)) &&
+                SUCCEEDED(writer->WriteSample(stream, sample));
+        }
+        SafeRelease(sample);
+        SafeRelease(buf);
+        return ok;
+    }
+
+    void Close() override
+    {
+        if (writer) writer->Finalize();
+        SafeRelease(writer);
+        if (started) MFShutdown();
+        started = false;
+    }
+};
+
+// Single producer (a render loop) and the encoder thread. The producer fills slots[head]
+// outside the lock, which is safe as long as the ring isn't full; the encoder takes the
+// oldest filled slot.
+struct CaptureRing
+{
+    struct Slot
+    {
+        std::vector<uint32_t> pixels;
+        int frame = 0;
+        LONGLONG time = 0;
+    };
+    Slot slots[CAPTURE_RING];
+    int width = 0;
+    int height = 0;
+    std::mutex m;
+    std::condition_variable cv;
+    int head = 0;    // next slot to fill
+    int filled = 0;  // slots waiting for the encoder
+    bool closing = false;
+    int opened = 0;  // encoder thread: 1 open, -1 failed
+    int written = 0;
+    int dropped = 0;
+    std::thread thread;
+    // producer side
+    int frames = 0;       // committed so far
+    double start = -1.0;  // live: render time of the first frame
+
+    // false, with no thread left, if the encoder can't open its output
+    bool Start(const wchar_t* base, int w, int h, int fps, bool png)
+    {
+        width = w;
+        height = h;
+        for (Slot& s : slots) s.pixels.resize((size_t)w * h);
+        std::wstring name = base;
+        thread = std::thread([this, name, fps, png] { Run(name, fps, png); });
+        std::unique_lock<std::mutex> lk(m);
+        cv.wait(lk, [&] { return opened != 0; });
+        bool ok = opened > 0;
+        lk.unlock();
+        if (!ok) thread.join();
+        return ok;
+    }
+
+    // next free slot; wait: until the encoder frees one, otherwise nullptr (dropped) when full
+    uint32_t* Acquire(bool wait)
+    {
+        std::unique_lock<std::mutex> lk(m);
+        if (wait) cv.wait(lk, [&] { return filled < CAPTURE_RING; });
+        else if (filled == CAPTURE_RING)
+        {
+            ++dropped;
+            return nullptr;
+        }
+        return slots[head].pixels.data();
+    }
+
+    void Commit(LONGLONG time)
+    {
+        {
+            std::lock_guard<std::mutex> lk(m);
+            slots[head].frame = frames++;
+            slots[head].time = time;
+            head = (head + 1) % CAPTURE_RING;
+            ++filled;
+        }
+        cv.notify_all();
+    }
+
+    void Drop()
+    {
+        std::lock_guard<std::mutex> lk(m);
+        ++dropped;
+    }
+
+    void Counts(int& w, int& d, int& queued)
+    {
+        std::lock_guard<std::mutex> lk(m);
+        w = written;
+        d = dropped;
+        queued = filled;
+    }
+
+    // encode what is queued, then close the output
+    void Stop()
+    {
+        {
+            std::lock_guard<std::mutex> lk(m);
+            closing = true;
+        }
+        cv.notify_all();
+        if (thread.joinable()) thread.join();
+    }
+
+    void Run(const std::wstring& base, int fps, bool png)
+    {
+        CoInitializeEx(NULL, COINIT_MULTITHREADED);
+        std::unique_ptr<CaptureEncoder> enc(png ? (CaptureEncoder*)new PngSequenceEncoder() : new Mp4Encoder());
+        bool ok = enc->Open(base.c_str(), width, height, fps);
+        {
+            std::lock_guard<std::mutex> lk(m);
+            opened = ok ? 1 : -1;
+        }
+        cv.notify_all();
+        while (ok)
+        {
+            std::unique_lock<std::mutex> lk(m);
+            cv.wait(lk, [&] { return filled > 0 || closing; });
+            if (!filled) break; // closing, all written
+            Slot& s = slots[(head - filled + CAPTURE_RING) % CAPTURE_RING];
+            lk.unlock();
+            bool wrote = enc->Write(s.pixels.data(), s.frame, s.time);
+            lk.lock();
+            --filled;
+            if (wrote) ++written;
+            else ++dropped;
+            lk.unlock();
+            cv.notify_all();
+        }
+        enc.reset(); // closes, COM objects go before CoUninitialize
+        CoUninitialize();
+    }
+};
+
+// Videos\MyStarfield_yyyymmdd_hhmmss, the saver runs with System32 as its directory
+static std::wstring CaptureBasePath()
+{
+    std::wstring dir = L".";
+    wchar_t* videos = nullptr;
+    if (SUCCEEDED(SHGetKnownFolderPath(FOLDERID_Videos, KF_FLAG_CREATE, NULL, &videos))) dir = videos;
+    CoTaskMemFree(videos);
+    SYSTEMTIME t;
+    GetLocalTime(&t);
+    wchar_t name[64];
+    swprintf_s(name, L"\\MyStarfield_%04u%02u%02u_%02u%02u%02u", t.wYear, t.wMonth, t.wDay, t.wHour, t.wMinute, t.wSecond);
+    return dir + name;
+}
+
+// Live capture of one window, even size for H.264; nullptr if the output can't be opened
+static CaptureRing* StartLiveCapture(RenderWindow* rw)
+{
+    int w = max(2, (rw->rc.right - rw->rc.left) & ~1);
+    int h = max(2, (rw->rc.bottom - rw->rc.top) & ~1);
+    std::wstring base = CaptureBasePath();
+    CaptureRing* ring = new CaptureRing();
+    if (!ring->Start(base.c_str(), w, h, rw->refreshHz, g_CapturePng))
+    {
+        LogLine("[MyStarfield] capture: can't open %ws", base.c_str());
+        delete ring;
+        return nullptr;
+    }
+    LogLine("[MyStarfield] capture: window %d %dx%d to %ws", rw->index, w, h, base.c_str());
+    return ring;
+}
+
+// The frame just drawn, dropped when the encoder is behind; the saver never waits on it
+static void CaptureFrame(RenderWindow* rw, double totalTime)
+{
+    CaptureRing* ring = rw->capture;
+    if (ring->start < 0.0) ring->start = totalTime;
+    uint32_t* dst = ring->Acquire(false);
+    if (!dst) return;
+    if (rw->renderer->ReadFrame(rw, dst, ring->width, ring->height)) ring->Commit((LONGLONG)((totalTime - ring->start) * 1e7));
+    else ring->Drop();
+}
+
+static void StopLiveCapture(RenderWindow* rw)
+{
+    if (!rw->capture) return;
+    rw->capture->Stop();
+    int written, dropped, queued;
+    rw->capture->Counts(written, dropped, queued);
+    LogLine("[MyStarfield] capture: window %d, %d frames written, %d dropped", rw->index, written, dropped);
+    delete rw->capture;
+    rw->capture = nullptr;
+}
+
+// ---- Stats reporting
+static const char* RenderPathName(RenderPath p)
+{
+    return p == RENDER_D3D11 ? "D3D11" : (p == RENDER_DIB ? "DIB" : "GDI");
+}
+
+static int FormatPhase(char* out, size_t size, Phase p, const PhaseSummary& s)
+{
+    return sprintf_s(out, size, "%-5s p50 %6.2f  p95 %6.2f  p99 %6.2f  min %6.2f  max %6.2f ms\n",
+        g_PhaseNames[p], s.p50, s.p95, s.p99, s.min, s.max);
+}
+
+static void TracePhase(int window, Phase p, const PhaseSummary& s)
+{
+    TraceLoggingWrite(g_TraceProvider, "FrameStats", TraceLoggingInt32(window, "Window"),
+        TraceLoggingString(g_PhaseNames[p], "Phase"), TraceLoggingFloat32(s.p50, "P50"),
+        TraceLoggingFloat32(s.p95, "P95"), TraceLoggingFloat32(s.p99, "P99"),
+        TraceLoggingFloat32(s.min, "Min"), TraceLoggingFloat32(s.max, "Max"));
+}
+
+// Once a second, from whoever renders the window: debug log + ETW event per phase, HUD text
+static void ReportStats(RenderWindow* rw, double fps)
+{
+    static const Phase windowPhases[] = { PHASE_FRAME, PHASE_SIMULATE, PHASE_DRAW, PHASE_PRESENT };
+    char text[sizeof(rw->hudText)];
+    // stars actually simulated and drawn (power throttle, governor), then the field size
+    int len = sprintf_s(text, "MyStarfield  %s  %d / %d stars  %.1f fps  %d Hz  %u dpi\n",
+        rw->renderer ? RenderPathName(rw->renderer->Path()) : "-", rw->simulated, (rw->field ? *rw->field : rw->stars).size(),
+        fps, rw->refreshHz, rw->dpi);
+    for (Phase p : windowPhases)
+    {
+        PhaseSummary s = rw->stats.Summarize(p);
+        len += FormatPhase(text + len, sizeof(text) - len, p, s);
+        TracePhase(rw->index, p, s);
+    }
+    const int* lod = rw->lodCounts;
+    const int lodPixel = min(MAX_PSZ, g_LodPixel + rw->gov.LodBoost()), lodQuad = min(MAX_PSZ, g_LodQuad + rw->gov.LodBoost());
+    len += sprintf_s(text + len, sizeof(text) - len, "lod   1px %d (r<=%d)  2x2 %d (r<=%d)  sprite %d\n",
+        lod[0], lodPixel, lod[1], lodQuad, lod[2]);
+    TraceLoggingWrite(g_TraceProvider, "LodTiers", TraceLoggingInt32(rw->index, "Window"),
+        TraceLoggingInt32(lodPixel, "PixelMaxRadius"), TraceLoggingInt32(lodQuad, "QuadMaxRadius"),
+        TraceLoggingInt32(lod[0], "Pixels"), TraceLoggingInt32(lod[1], "Quads"), TraceLoggingInt32(lod[2], "Sprites"));
+    if (g_Governor && !rw->isPreview)
+    {
+        const QualityGovernor& g = rw->gov;
+        len += sprintf_s(text + len, sizeof(text) - len, "gov   level %d/%d  stars %d%%  lod +%d  fx %s  work %.2f / %.2f ms\n",
+            g.level, GOV_LEVELS, g.StarsPct(), g.LodBoost(), g.Effects() ? "on" : "off", g.workMs, g.periodMs);
+    }
+    if (rw->capture)
+    {
+        int written, dropped, queued;
+        rw->capture->Counts(written, dropped, queued);
+        len += sprintf_s(text + len, sizeof(text) - len, "rec   %d written  %d dropped  %d/%d queued\n", written, dropped, queued, CAPTURE_RING);
+    }
+    LogLine("[MyStarfield] window %d\n%s", rw->index, text);
+    memcpy(rw->hudText, text, sizeof(text));
+}
+
+// UI thread: the message pump is shared by all windows
+static void ReportPumpStats()
+{
+    PhaseSummary s = g_MainStats.Summarize(PHASE_PUMP);
+    char text[128];
+    FormatPhase(text, sizeof(text), PHASE_PUMP, s);
+    TracePhase(-1, PHASE_PUMP, s);
+    LogLine("[MyStarfield] %s", text);
+}
+
+// ---- Frame pacing
+// Waits for the next refresh of the window's own monitor (swap chain output, DwmFlush on the
+// primary) or, with a target FPS set, for the next tick of a high resolution waitable timer.
+// Frame work is measured so a window that can't keep up drops to a steady multiple of the
+// period instead of judder.
+struct FrameScheduler
+{
+    RenderWindow* rw = nullptr;  // whose monitor to follow, null = primary
+    bool vblank = true;          // pace on the display refresh
+    double period = 1.0 / 60.0;  // timer mode: seconds per frame
+    HANDLE timer = NULL;
+    bool highRes = false;
+    LONGLONG frameStart = 0;
+    LONGLONG next = 0;           // timer mode: next deadline (QPC ticks)
+    double workAvg = 0.0;        // smoothed frame work in seconds
+
+    void Init(int targetFps)
+    {
+        if (!g_PerfFreq.QuadPart) QueryPerformanceFrequency(&g_PerfFreq);
+        timer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+        highRes = (timer != NULL);
+        if (!timer) timer = CreateWaitableTimerExW(NULL, NULL, 0, TIMER_ALL_ACCESS); // pre 1803
+        SetTargetFps(targetFps);
+        frameStart = next;
+    }
+    // 0 = display refresh; can change while running (power throttling)
+    void SetTargetFps(int targetFps)
+    {
+        vblank = (targetFps <= 0);
+        period = 1.0 / (double)(targetFps > 0 ? targetFps : (rw ? rw->refreshHz : 60));
+        LARGE_INTEGER now;
+        QueryPerformanceCounter(&now);
+        next = now.QuadPart;
+    }
+    void Close()
+    {
+        if (timer) CloseHandle(timer);
+        timer = NULL;
+    }
+    void BeginFrame()
+    {
+        LARGE_INTEGER now;
+        QueryPerformanceCounter(&now);
+        frameStart = now.QuadPart;
+    }
+    // measure this frame and wait for the next slot
+    void EndFrame()
+    {
+        LARGE_INTEGER now;
+        QueryPerformanceCounter(&now);
+        double work = double(now.QuadPart - frameStart) / double(g_PerfFreq.QuadPart);
+        workAvg = workAvg * 0.9 + work * 0.1;
+        if (vblank)
+        {
+            if (rw && rw->renderer && rw->renderer->WaitForVBlank()) return;
+            // DWM composes at the primary's rate, other monitors get a timer at their own
+            if ((!rw || rw->primary) && SUCCEEDED(DwmFlush())) return;
+            vblank = false; // no composition (e.g. some RDP sessions): timer at the refresh rate
+            next = now.QuadPart;
+        }
+        // whole periods only, a slow frame costs an even 1/2, 1/3, ... of the rate
+        int slots = max(1, (int)ceil(workAvg / period - 0.05));
+        LONGLONG periodTicks = (LONGLONG)(period * (double)g_PerfFreq.QuadPart);
+        next += slots * periodTicks;
+        if (next < now.QuadPart - periodTicks) next = now.QuadPart; // fell behind, resync
+        WaitUntil(next);
+    }
+    void WaitUntil(LONGLONG deadline)
+    {
+        LARGE_INTEGER now;
+        QueryPerformanceCounter(&now);
+        double remain = double(deadline - now.QuadPart) / double(g_PerfFreq.QuadPart);
+        // a plain timer is only good to ~1ms, sleep short of the deadline and yield the rest
+        double slack = highRes ? 0.0 : 0.002;
+        if (timer && remain > slack)
+        {
+            LARGE_INTEGER due;
+            due.QuadPart = -(LONGLONG)((remain - slack) * 1e7); // relative, 100ns units
+            if (SetWaitableTimer(timer, &due, 0, NULL, NULL, FALSE)) WaitForSingleObject(timer, INFINITE);
+        }
+        for (;;)
+        {
+            QueryPerformanceCounter(&now);
+            if (now.QuadPart >= deadline) break;
+            Sleep(0);
+        }
+    }
+};
+
+// Render worker: one per fullscreen window, owns its backbuffer, RNG and pacing while
+// running. Windows run free at their own monitor's rate; they share the clock, so the
+// field stays in step across monitors without waiting on each other.
+// Startup in the worker: windows are already up and black, every monitor builds its
+// renderer and star field in parallel and shows its first frame as soon as that's done.
+static void StartWorker(RenderWindow* rw)
+{
+    if (rw->resized.exchange(false))
+    {
+        {
+            std::lock_guard<std::mutex> lk(rw->sizeMutex);
+            rw->rc = rw->pendingRc;
+            rw->desktopPos = rw->pendingPos;
+        }
+        if (rw->field) UpdateSharedSlice(rw);
+    }
+    CreateBackbuffer(rw);
+    // the first worker here builds the shared field, the others wait for it
+    if (rw->field) std::call_once(g_Shared.once, InitSharedField);
+    else InitStars(rw);
+    if (g_CaptureLive && rw->primary) rw->capture = StartLiveCapture(rw);
+}
+
+static void ReportFirstFrame(RenderWindow* rw)
+{
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    float ms = (float)(double(now.QuadPart - g_LaunchCounter.QuadPart) * 1000.0 / double(g_PerfFreq.QuadPart));
+    TraceLoggingWrite(g_TraceProvider, "FirstFrame", TraceLoggingInt32(rw->index, "Window"), TraceLoggingFloat32(ms, "Ms"));
+    LogLine("[MyStarfield] window %d: first frame %.1f ms after launch", rw->index, ms);
+}
+
+static void ReportGovernor(RenderWindow* rw)
+{
+    const QualityGovernor& g = rw->gov;
+    TraceLoggingWrite(g_TraceProvider, "Governor", TraceLoggingInt32(rw->index, "Window"),
+        TraceLoggingInt32(g.level, "Level"), TraceLoggingInt32(g.StarsPct(), "StarsPct"),
+        TraceLoggingInt32(g.LodBoost(), "LodBoost"), TraceLoggingBool(g.Effects(), "Effects"),
+        TraceLoggingFloat32(g.workMs, "WorkMs"), TraceLoggingFloat32(g.periodMs, "PeriodMs"));
+    LogLine("[MyStarfield] window %d: quality level %d (stars %d%%, lod +%d, fx %s), work %.2f ms of %.2f",
+        rw->index, g.level, g.StarsPct(), g.LodBoost(), g.Effects() ? "on" : "off", g.workMs, g.periodMs);
+}
+
+static void RenderWorker(RenderWindow* rw)
+{
+    StartWorker(rw);
+    FrameScheduler sched;
+    sched.rw = rw;
+    int fps = rw->targetFps;
+    sched.Init(fps);
+    LARGE_INTEGER last;
+    QueryPerformanceCounter(&last);
+    double lastReport = 0.0;
+    int reportFrames = 0;
+    while (g_Running)
+    {
+        if (!rw->active)
+        {
+            WaitForSingleObject(rw->wake, INFINITE);
+            QueryPerformanceCounter(&last); // resume without a time jump
+            continue;
         }
-        else if (argc >= 3)
+        int want = rw->targetFps;
+        if (want != fps) sched.SetTargetFps(fps = want);
+        if (rw->resized.exchange(false))
         {
-            std::wstring a2 = argv[2];
-            bool numeric = !a2.empty();
-            for (wchar_t ch : a2) if (!iswdigit(ch)) { numeric = false; break; }
-            if (numeric) hwndOut = (HWND)_wcstoui64(a2.c_str(), nullptr, 0);
+            RECT old = rw->rc;
+            {
+                std::lock_guard<std::mutex> lk(rw->sizeMutex);
+                rw->rc = rw->pendingRc;
+                rw->desktopPos = rw->pendingPos;
+            }
+            if (rw->field) UpdateSharedSlice(rw); // the next desktop pass cuts the new rect
+            CreateBackbuffer(rw); // renderers resize in place
+            if (!rw->field) RescaleStars(rw->stars, old.right - old.left, old.bottom - old.top,
+                rw->rc.right - rw->rc.left, rw->rc.bottom - rw->rc.top);
         }
+        sched.BeginFrame();
+        LARGE_INTEGER now;
+        QueryPerformanceCounter(&now);
+        double dt = double(now.QuadPart - last.QuadPart) / double(g_PerfFreq.QuadPart);
+        double total = double(now.QuadPart - g_StartCounter.QuadPart) / double(g_PerfFreq.QuadPart);
+        last = now;
+        rw->stats.Add(PHASE_FRAME, (float)(dt * 1000.0));
+        UpdateField(rw, total);
+        RenderFrame(rw, (float)dt, total);
+        if (!g_Running) break; // exit came in mid-frame, the window is going away
+        if (rw->capture) CaptureFrame(rw, total);
+        PresentFrame(rw);
+        if (!rw->presented.exchange(true)) ReportFirstFrame(rw);
+        ++reportFrames;
+        if (total - lastReport >= 1.0)
+        {
+            ReportStats(rw, reportFrames / (total - lastReport));
+            lastReport = total;
+            reportFrames = 0;
+        }
+        sched.EndFrame();
+        if (!g_Governor) rw->gov.Reset();
+        else if (rw->gov.Update(sched.workAvg, sched.period, total)) ReportGovernor(rw);
+        rw->govLevel = rw->gov.level;
     }
+    sched.Close();
+    StopLiveCapture(rw);
 }
 
-// ---- backbuffer helpers
-static bool CreateBackbuffer(RenderWindow* rw)
+// ---- Foreground check and window procs
+// False when hidden (also via a parent: Settings page closed), minimized or
+// DWM cloaked (other virtual desktop, covered by a UWP / secure surface)
+static bool WindowShowing(HWND hwnd)
 {
-    if (!rw || !rw->hwnd) return false;
-    HDC wnd = GetDC(rw->hwnd);
-    if (!wnd) return false;
-    // release existing
-    if (rw->backHdc)
-    {
-        SelectObject(rw->backHdc, rw->oldBackBmp);
-        DeleteObject(rw->backBmp);
-        DeleteDC(rw->backHdc);
-        rw->backHdc = NULL; 
-        rw->backBmp = NULL; 
-        rw->oldBackBmp = NULL;
-    }
-    int w = max(1, rw->rc.right - rw->rc.left);
-    int h = max(1, rw->rc.bottom - rw->rc.top);
-    HDC mem = CreateCompatibleDC(wnd);
-    HBITMAP bmp = CreateCompatibleBitmap(wnd, w, h);
-    if (!mem || !bmp)
-    {
-        if (mem) DeleteDC(mem);
-        ReleaseDC(rw->hwnd, wnd);
-        return false;
-    }
-    rw->oldBackBmp = (HBITMAP)SelectObject(mem, bmp);
-    rw->backHdc = mem;
-    rw->backBmp = bmp;
-    // init black background
-    HBRUSH b = (HBRUSH)GetStockObject(BLACK_BRUSH);
-    RECT rc = { 0,0,w,h };
-    FillRect(rw->backHdc, &rc, b);
-    ReleaseDC(rw->hwnd, wnd);
+    if (!IsWindowVisible(hwnd)) return false;
+    HWND root = GetAncestor(hwnd, GA_ROOT);
+    if (!root || IsIconic(root)) return false;
+    DWORD cloaked = 0;
+    if (SUCCEEDED(DwmGetWindowAttribute(root, DWMWA_CLOAKED, &cloaked, sizeof(cloaked))) && cloaked) return false;
     return true;
 }
 
-static void DestroyBackbuffer(RenderWindow* rw)
+// ---- Power awareness (fullscreen): display off or session locked / disconnected
+// suspends rendering outright, battery or battery saver throttles rate and stars.
+static const int POWER_SAVE_FPS = 30;
+static const int POWER_SAVE_STARS_PCT = 50;
+static const DWORD STATE_POLL_MS = 250; // UI thread: window visibility re-check
+
+struct PowerState
 {
-    if (!rw) return;
-    if (rw->backHdc)
+    bool displayOn = true;     // GUID_CONSOLE_DISPLAY_STATE, dimmed counts as on
+    bool sessionActive = true; // WTS lock / disconnect
+    bool onBattery = false;    // GUID_ACDC_POWER_SOURCE
+    bool batterySaver = false; // GUID_POWER_SAVING_STATUS
+    bool changed = true;       // RunFull re-applies the throttle
+    bool Suspended() const { return !displayOn || !sessionActive; }
+    bool Throttled() const { return onBattery || batterySaver; }
+};
+static PowerState g_Power;
+static HPOWERNOTIFY g_PowerNotify[3] = {};
+
+// registered on one window, 'all' notifications come to it
+static void RegisterPowerNotifications(HWND hwnd)
+{
+    const GUID* settings[3] = { &GUID_CONSOLE_DISPLAY_STATE, &GUID_ACDC_POWER_SOURCE, &GUID_POWER_SAVING_STATUS };
+    for (int i = 0; i < 3; ++i) g_PowerNotify[i] = RegisterPowerSettingNotification(hwnd, settings[i], DEVICE_NOTIFY_WINDOW_HANDLE);
+    WTSRegisterSessionNotification(hwnd, NOTIFY_FOR_THIS_SESSION);
+}
+
+static void UnregisterPowerNotifications(HWND hwnd)
+{
+    for (HPOWERNOTIFY& h : g_PowerNotify)
     {
-        SelectObject(rw->backHdc, rw->oldBackBmp);
-        DeleteObject(rw->backBmp);
-        DeleteDC(rw->backHdc);
-        rw->backHdc = NULL; 
-        rw->backBmp = NULL; 
-        rw->oldBackBmp = NULL;
+        if (h) UnregisterPowerSettingNotification(h);
+        h = NULL;
     }
+    WTSUnRegisterSessionNotification(hwnd);
 }
 
-// InitStars: centered world coords (so projection works predictably)
-// Smaller Z_MIN(closer to 0) makes stars appear larger and move faster
-// as they approach because projection uses 1 / z.
-static const float Z_MIN = 1.0f;
-// decrease Z_MAX (e.g., 800) to bring more stars visually forward
-static const float Z_MAX = 33.0f;
-// FOCAL ~ 1.0 is appropriate for the sample values (x ~ [-1600..1600], z ~ [10..100])
-static const float FOCAL = 9.0f;
-// multiplier that controls drawn core size; increase for larger stars
-static const float SIZE_SCALE = 1.0f;
-
-static void InitStars(RenderWindow* rw)
+// WM_POWERBROADCAST / WM_WTSSESSION_CHANGE -> g_Power
+static void HandlePowerMessage(UINT msg, WPARAM wParam, LPARAM lParam)
 {
-    if (!rw) return;
-    RECT r = rw->rc;
-    int width = max(1, r.right - r.left);
-    int height = max(1, r.bottom - r.top);
-    rw->stars.clear();
-    rw->stars.resize(g_StarCount);
-    int jitterMax = max(1, g_Speed / 2 + 1);
-    std::uniform_real_distribution<float> ud01(0.0f, 1.0f);
-
-    for (int i = 0; i < g_StarCount; ++i)
+    if (msg == WM_POWERBROADCAST && wParam == PBT_POWERSETTINGCHANGE && lParam)
     {
-        float fx = ud01(rw->rng);
-        float fy = ud01(rw->rng);
-        float fz = ud01(rw->rng);
-
-        // centered world coords as in your samples
-        rw->stars[i].x = (fx - 0.5f) * (float)width * 2.0f;
-        rw->stars[i].y = (fy - 0.5f) * (float)height * 2.0f;
-
-        // deep range (classic)
-        rw->stars[i].z = fz * (Z_MAX - Z_MIN) + Z_MIN;
-        rw->stars[i].speed = (float)g_Speed + float(rw->rng() % jitterMax);
+        const POWERBROADCAST_SETTING* ps = (const POWERBROADCAST_SETTING*)lParam;
+        if (ps->DataLength < sizeof(DWORD)) return;
+        DWORD value = *(const DWORD*)ps->Data;
+        if (ps->PowerSetting == GUID_CONSOLE_DISPLAY_STATE) g_Power.displayOn = (value != 0);
+        else if (ps->PowerSetting == GUID_ACDC_POWER_SOURCE) g_Power.onBattery = (value != 0);
+        else if (ps->PowerSetting == GUID_POWER_SAVING_STATUS) g_Power.batterySaver = (value != 0);
+        else return;
+        g_Power.changed = true;
+    }
+    else if (msg == WM_WTSSESSION_CHANGE)
+    {
+        switch (wParam)
+        {
+            case WTS_SESSION_LOCK:
+            case WTS_CONSOLE_DISCONNECT:
+            case WTS_REMOTE_DISCONNECT:
+                g_Power.sessionActive = false;
+                break;
+            case WTS_SESSION_UNLOCK:
+            case WTS_CONSOLE_CONNECT:
+            case WTS_REMOTE_CONNECT:
+                g_Power.sessionActive = true;
+                break;
+            default:
+                return;
+        }
+        g_Power.changed = true;
     }
 }
 
-// RenderFrame tuned to the sample values (uses totalTime)
-static void RenderFrame(RenderWindow* rw, float dt, float totalTime)
+static bool ForegroundIsOurWindow()
 {
-    if (!rw || !rw->backHdc) return;
-    int w = max(1, rw->rc.right - rw->rc.left);
-    int h = max(1, rw->rc.bottom - rw->rc.top);
-    float cx = w * 0.5f, cy = h * 0.5f;
-
-    // clear
-    RECT fill = { 0,0,w,h };
-    FillRect(rw->backHdc, &fill, (HBRUSH)GetStockObject(BLACK_BRUSH));
-
-    HPEN oldPen = (HPEN)SelectObject(rw->backHdc, GetStockObject(NULL_PEN));
-    int baseR = GetRValue(g_Color), baseG = GetGValue(g_Color), baseB = GetBValue(g_Color);
+    HWND fg = GetForegroundWindow();
+    if (!fg) return false;
+    DWORD fgPid = 0;
+    GetWindowThreadProcessId(fg, &fgPid);
+    return (fgPid == GetCurrentProcessId());
+}
 
-    // subtle pulse
-    float pulse = 1.0f + 0.05f * sinf(totalTime * 1.5f);
+// ---- Input (fullscreen): raw input on a thread of its own, so exit waits neither on the
+// UI thread nor on a frame. FullWndProc's messages are the fallback if registration fails.
+static std::atomic<bool> g_RawInput{ false };
+static HWND g_InputHwnd = NULL;
+static DWORD g_UiThreadId = 0;
 
-    // small brush cache (few buckets)
-    const int BUCKETS = 6;
-    HBRUSH brushes[BUCKETS] = { 0 };
+// Stop now: sleeping workers are woken to see g_Running, the UI thread leaves its wait
+// and hides the windows before it joins anyone
+static void RequestExit()
+{
+    if (!g_Running.exchange(false)) return;
+    for (auto rw : g_Windows) SetEvent(rw->wake);
+    PostThreadMessageW(g_UiThreadId, WM_NULL, 0, 0);
+}
 
-    for (auto& s : rw->stars)
+// Debounce, foreground and mouse distance checks, shared by both input paths
+static bool InputEndsSaver(bool mouseMove)
+{
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    double seconds = double(now.QuadPart - g_StartCounter.QuadPart) / double(g_PerfFreq.QuadPart);
+    if (seconds < g_InputDebounceSeconds) return false;
+    if (!ForegroundIsOurWindow()) return false;
+    if (mouseMove)
     {
-        // advance depth
-        s.z -= s.speed * dt * 0.5f;
-        if (s.z <= Z_MIN) {
-            // respawn centered and far
-            std::uniform_real_distribution<float> ud01(0.0f, 1.0f);
-            float fx = ud01(rw->rng), fy = ud01(rw->rng), fz = ud01(rw->rng);
-            s.x = (fx - 0.5f) * (float)w * 2.0f;
-            s.y = (fy - 0.5f) * (float)h * 2.0f;
-            s.z = fz * (Z_MAX - Z_MIN) + Z_MIN;
-            int jitterMax = max(1, g_Speed / 2 + 1);
-            s.speed = (float)g_Speed + float(rw->rng() % jitterMax);
+        POINT cur; GetCursorPos(&cur);
+        if (!g_StartMouseInit)
+        {
+            g_StartMouse = cur;
+            g_StartMouseInit = true;
+            return false;
         }
+        int dx = abs(cur.x - g_StartMouse.x), dy = abs(cur.y - g_StartMouse.y);
+        if (dx < g_MouseMoveThreshold && dy < g_MouseMoveThreshold) return false;
+    }
+    return true;
+}
 
-        // projection using small focal factor
-        float px = cx + s.x * (FOCAL / s.z);
-        float py = cy + s.y * (FOCAL / s.z);
-
-        // size scales with inverse depth; near -> larger
-        float inv = (Z_MIN / s.z); // near => closer to 1
-        int psz = (int)ceilf(max(1.0f, SIZE_SCALE * inv));
-        if (psz > 128) psz = 128;
-
-        // intensity from depth (near -> brighter) then pulsate
-        float t = (s.z - Z_MIN) / (Z_MAX - Z_MIN); // 0..1
-        float depthIntensity = 1.0f - t;
-        int intensity = (int)lroundf(100.0f + depthIntensity * 155.0f * pulse);
-        intensity = max(0, min(255, intensity));
+static const RAWINPUTDEVICE g_InputDevices[2] = {
+    { 0x01, 0x02, RIDEV_INPUTSINK, NULL }, // generic desktop: mouse
+    { 0x01, 0x06, RIDEV_INPUTSINK, NULL }, // keyboard
+};
 
-        // map to bucket
-        int bucket = (int)((intensity) / (256.0f / BUCKETS));
-        bucket = max(0, min(BUCKETS - 1, bucket));
-        if (!brushes[bucket])
+static LRESULT CALLBACK InputWndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
+{
+    switch (msg)
+    {
+        case WM_INPUT:
         {
-            int br = (baseR * intensity) / 255;
-            int bg = (baseG * intensity) / 255;
-            int bb = (baseB * intensity) / 255;
-            // slightly move nearer buckets toward white for pop
-            float whiten = 0.5f + 0.5f * (bucket / (float)(BUCKETS - 1));
-            br = min(255, (int)lroundf(br * whiten + 255 * (1.0f - whiten)));
-            bg = min(255, (int)lroundf(bg * whiten + 255 * (1.0f - whiten)));
-            bb = min(255, (int)lroundf(bb * whiten + 255 * (1.0f - whiten)));
-            brushes[bucket] = CreateSolidBrush(RGB(br, bg, bb));
+            RAWINPUT ri;
+            UINT size = sizeof(ri);
+            if (GetRawInputData((HRAWINPUT)lParam, RID_INPUT, &ri, &size, sizeof(RAWINPUTHEADER)) == (UINT)-1) break;
+            bool ends = false;
+            if (ri.header.dwType == RIM_TYPEKEYBOARD)
+            {
+                ends = !(ri.data.keyboard.Flags & RI_KEY_BREAK) && InputEndsSaver(false);
+            }
+            else if (ri.header.dwType == RIM_TYPEMOUSE)
+            {
+                const RAWMOUSE& m = ri.data.mouse;
+                const USHORT downs = RI_MOUSE_LEFT_BUTTON_DOWN | RI_MOUSE_RIGHT_BUTTON_DOWN |
+                    RI_MOUSE_MIDDLE_BUTTON_DOWN | RI_MOUSE_BUTTON_4_DOWN | RI_MOUSE_BUTTON_5_DOWN;
+                if (m.usButtonFlags & downs) ends = InputEndsSaver(false);
+                else if (m.lLastX || m.lLastY || (m.usFlags & MOUSE_MOVE_ABSOLUTE)) ends = InputEndsSaver(true);
+            }
+            if (ends) RequestExit();
+            break; // DefWindowProc frees the input
         }
-
-        // skip if offscreen
-        if (px + psz < 0 || px - psz > w || py + psz < 0 || py - psz > h) continue;
-        HBRUSH oldBrush = nullptr;
-        if (brushes[bucket]) {
-            oldBrush = (HBRUSH)SelectObject(rw->backHdc, brushes[bucket]);
-            Ellipse(rw->backHdc,
-                (int)floorf(px - psz), (int)floorf(py - psz),
-                (int)ceilf(px + psz + 1), (int)ceilf(py + psz + 1));
-            SelectObject(rw->backHdc, oldBrush);
+        case WM_CLOSE:
+        {
+            RAWINPUTDEVICE remove[2] = { g_InputDevices[0], g_InputDevices[1] };
+            for (auto& d : remove) d.dwFlags = RIDEV_REMOVE;
+            RegisterRawInputDevices(remove, 2, sizeof(RAWINPUTDEVICE));
+            DestroyWindow(hWnd);
+            return 0;
         }
+        case WM_DESTROY:
+            PostQuitMessage(0);
+            return 0;
     }
-
-    // cleanup
-    for (int i = 0; i < BUCKETS; ++i) if (brushes[i])
-    {
-        DeleteObject(brushes[i]); brushes[i] = NULL;
-    }
-    SelectObject(rw->backHdc, oldPen);
-    // blit
-    HDC wnd = GetDC(rw->hwnd);
-    BitBlt(wnd, 0, 0, w, h, rw->backHdc, 0, 0, SRCCOPY);
-    ReleaseDC(rw->hwnd, wnd);
+    return DefWindowProcW(hWnd, msg, wParam, lParam);
 }
 
-// ---- Foreground check and window procs
-static bool ForegroundIsOurWindow()
+// Message-only window sinking mouse and keyboard raw input; sets ready once g_RawInput is known
+static void InputThread(HANDLE ready)
 {
-    HWND fg = GetForegroundWindow();
-    if (!fg) return false;
-    DWORD fgPid = 0;
-    GetWindowThreadProcessId(fg, &fgPid);
-    return (fgPid == GetCurrentProcessId());
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_ABOVE_NORMAL);
+    WNDCLASSW wc = {};
+    wc.lpfnWndProc = InputWndProc;
+    wc.hInstance = g_Hinst;
+    wc.lpszClassName = L"StarfieldInputClass";
+    RegisterClassW(&wc);
+    HWND hwnd = CreateWindowExW(0, wc.lpszClassName, L"", 0, 0, 0, 0, 0, HWND_MESSAGE, NULL, g_Hinst, NULL);
+    RAWINPUTDEVICE devs[2] = { g_InputDevices[0], g_InputDevices[1] };
+    for (auto& d : devs) d.hwndTarget = hwnd; // INPUTSINK: delivered though this window is never foreground
+    g_RawInput = hwnd && RegisterRawInputDevices(devs, 2, sizeof(RAWINPUTDEVICE));
+    if (!g_RawInput && hwnd)
+    {
+        DestroyWindow(hwnd);
+        hwnd = NULL;
+    }
+    g_InputHwnd = hwnd;
+    SetEvent(ready);
+    if (!hwnd)
+    {
+        LogLine("[MyStarfield] raw input unavailable, input handled on the UI thread");
+        return;
+    }
+    MSG msg;
+    while (GetMessageW(&msg, NULL, 0, 0) > 0) DispatchMessageW(&msg);
 }
 
 // Fullscreen window proc (uses input filtering)
@@ -315,9 +3794,19 @@ LRESULT CALLBACK FullWndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
         case WM_SIZE:
             if (rw)
             {
-                GetClientRect(hWnd, &rw->rc);
-                DestroyBackbuffer(rw);
-                CreateBackbuffer(rw);
+                // the worker owns the backbuffer, it resizes before its next frame
+                RECT rc;
+                GetClientRect(hWnd, &rc);
+                MONITORINFO mi = {};
+                mi.cbSize = sizeof(mi);
+                POINT pos = rw->desktopPos;
+                if (GetMonitorInfoW(MonitorFromWindow(hWnd, MONITOR_DEFAULTTONEAREST), &mi)) pos = { mi.rcMonitor.left, mi.rcMonitor.top };
+                {
+                    std::lock_guard<std::mutex> lk(rw->sizeMutex);
+                    rw->pendingRc = rc;
+                    rw->pendingPos = pos;
+                    rw->resized = true;
+                }
                 g_StartMouseInit = false;
             }
             return 0;
@@ -327,28 +3816,19 @@ LRESULT CALLBACK FullWndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
         case WM_MBUTTONDOWN:
         case WM_XBUTTONDOWN:
         case WM_MOUSEMOVE:
-        {
-            LARGE_INTEGER now;
-            QueryPerformanceCounter(&now);
-            double seconds = double(now.QuadPart - g_StartCounter.QuadPart) / double(g_PerfFreq.QuadPart);
-            if (seconds < g_InputDebounceSeconds) { return 0; }
-            if (!ForegroundIsOurWindow()) { return 0; }
-            if (msg == WM_MOUSEMOVE)
-            {
-                POINT cur; GetCursorPos(&cur);
-                if (!g_StartMouseInit)
-                {
-                    g_StartMouse = cur;
-                    g_StartMouseInit = true;
-                    return 0;
-                }
-                int dx = abs(cur.x - g_StartMouse.x), dy = abs(cur.y - g_StartMouse.y);
-                if (dx < g_MouseMoveThreshold && dy < g_MouseMoveThreshold) { return 0; }
-            }
-            g_Running = false; 
-            PostQuitMessage(0);
+            // the input thread sees the same input first, as raw input
+            if (!g_RawInput && InputEndsSaver(msg == WM_MOUSEMOVE)) RequestExit();
             return 0;
-        }
+        case WM_POWERBROADCAST:
+            HandlePowerMessage(msg, wParam, lParam);
+            return TRUE;
+        case WM_WTSSESSION_CHANGE:
+            HandlePowerMessage(msg, wParam, lParam);
+            return 0;
+        case WM_ERASEBKGND:
+            // class brush paints black until the worker has a frame up
+            if (rw && rw->presented) return 1;
+            return DefWindowProcW(hWnd, msg, wParam, lParam);
         case WM_DESTROY:
             return 0;
         default:
@@ -356,18 +3836,38 @@ LRESULT CALLBACK FullWndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
     }
 }
 
+// ---- Preview (/p): the Control Panel thumbnail gets a cut-down pipeline, a star
+// count scaled to its area, a lower rate, and no rendering at all while hidden.
+static const int PREVIEW_FPS = 30;
+static const int PREVIEW_MIN_STARS = 100;
+static const DWORD PREVIEW_IDLE_POLL_MS = 250; // visibility re-check while paused
+
+// full screen star density applied to the thumbnail, with a floor so it isn't empty
+static int PreviewStarCount(const RECT& rc)
+{
+    return max(min(PREVIEW_MIN_STARS, (int)g_StarCount), StarsForArea(rc.right - rc.left, rc.bottom - rc.top));
+}
+
 // Preview proc
+// The render loop owns the drawing; WM_PAINT only restores the last frame, which is
+// all there is while the loop is paused
 LRESULT CALLBACK PreviewProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
 {
     switch (msg)
     {
         case WM_ERASEBKGND: 
             return 1;
+        case WM_SHOWWINDOW:
+            if (wParam) InvalidateRect(hWnd, NULL, FALSE);
+            return 0;
         case WM_PAINT:
         {
             PAINTSTRUCT ps;
             HDC hdc = BeginPaint(hWnd, &ps);
-            FillRect(hdc, &ps.rcPaint, (HBRUSH)GetStockObject(BLACK_BRUSH));
+            RenderWindow* rw = (RenderWindow*)GetWindowLongPtrW(hWnd, GWLP_USERDATA);
+            const RECT& r = ps.rcPaint;
+            if (rw && rw->backHdc) BitBlt(hdc, r.left, r.top, r.right - r.left, r.bottom - r.top, rw->backHdc, r.left, r.top, SRCCOPY);
+            else FillRect(hdc, &ps.rcPaint, (HBRUSH)GetStockObject(BLACK_BRUSH));
             EndPaint(hWnd, &ps);
             return 0;
         }
@@ -385,16 +3885,30 @@ static BOOL CALLBACK MonEnumProc(HMONITOR hMon, HDC, LPRECT, LPARAM)
     RECT r = mi.rcMonitor;
     RenderWindow* rw = new RenderWindow();
     rw->rc = r;
+    rw->index = (int)g_Windows.size();
+    rw->primary = (mi.dwFlags & MONITORINFOF_PRIMARY) != 0;
+    UINT dpiX = 96, dpiY = 96;
+    if (SUCCEEDED(GetDpiForMonitor(hMon, MDT_EFFECTIVE_DPI, &dpiX, &dpiY))) rw->dpi = dpiX;
+    DEVMODEW dm = {};
+    dm.dmSize = sizeof(dm);
+    // 0 / 1 mean "hardware default"
+    if (EnumDisplaySettingsW(mi.szDevice, ENUM_CURRENT_SETTINGS, &dm) && dm.dmDisplayFrequency > 1) rw->refreshHz = (int)dm.dmDisplayFrequency;
+    rw->starCount = StarsForArea(r.right - r.left, r.bottom - r.top);
+    rw->desktopPos.x = r.left;
+    rw->desktopPos.y = r.top;
+    rw->wake = CreateEventW(NULL, FALSE, FALSE, NULL);
     std::random_device rd;
-    rw->rng.seed(rd());
+    rw->rng.Seed(((uint64_t)rd() << 32) | rd());
     static bool reg = false;
     if (!reg)
     {
         WNDCLASSW wc = {}; 
+        wc.style = CS_OWNDC; // GdiRenderer keeps the window DC
         wc.lpfnWndProc = FullWndProc; 
         wc.hInstance = g_Hinst;
         wc.lpszClassName = L"StarfieldFullClass";
         wc.hCursor = LoadCursor(NULL, IDC_ARROW);
+        wc.hbrBackground = (HBRUSH)GetStockObject(BLACK_BRUSH);
         RegisterClassW(&wc); 
         reg = true;
     }
@@ -402,6 +3916,7 @@ static BOOL CALLBACK MonEnumProc(HMONITOR hMon, HDC, LPRECT, LPARAM)
         r.left, r.top, r.right - r.left, r.bottom - r.top, NULL, NULL, g_Hinst, NULL);
     if (!hwnd)
     {
+        CloseHandle(rw->wake);
         delete rw;
         return TRUE;
     }
@@ -409,50 +3924,165 @@ static BOOL CALLBACK MonEnumProc(HMONITOR hMon, HDC, LPRECT, LPARAM)
     SetWindowLongPtrW(hwnd, GWLP_USERDATA, (LONG_PTR)rw);
     ShowWindow(hwnd, SW_SHOW);
     GetClientRect(hwnd, &rw->rc);
-    CreateBackbuffer(rw);
-    InitStars(rw);
+    // only monitors that got a window are part of the shared field
+    if (g_SharedField)
+    {
+        rw->field = &g_Shared.stars;
+        UnionRect(&g_Shared.rc, &g_Shared.rc, &r);
+        g_Shared.count += rw->starCount;
+        g_Shared.dpi = max(g_Shared.dpi, rw->dpi);
+    }
+    // backbuffer and stars are built by the window's worker (StartWorker)
     g_Windows.push_back(rw);
+    LogLine("[MyStarfield] monitor %d: %dx%d %d Hz %u dpi%s, %d stars", rw->index, r.right - r.left,
+        r.bottom - r.top, rw->refreshHz, rw->dpi, rw->primary ? " (primary)" : "", (int)rw->starCount);
     return TRUE;
 }
 
+// Rate and star budget for the current power source, workers pick it up on their next frame
+static void ApplyPowerThrottle()
+{
+    bool throttle = g_Power.Throttled();
+    int fps = g_TargetFps;
+    if (throttle) fps = g_TargetFps > 0 ? min(g_TargetFps, POWER_SAVE_FPS) : POWER_SAVE_FPS;
+    for (auto rw : g_Windows)
+    {
+        rw->targetFps = fps;
+        int stars = rw->field ? g_Shared.count : (int)rw->starCount;
+        rw->activeStars = throttle ? max(1, stars * POWER_SAVE_STARS_PCT / 100) : 0;
+    }
+    g_Power.changed = false;
+    LogLine("[MyStarfield] power: display %d session %d battery %d saver %d", (int)g_Power.displayOn,
+        (int)g_Power.sessionActive, (int)g_Power.onBattery, (int)g_Power.batterySaver);
+}
+
+// ---- Hot reload (fullscreen): a watcher thread waits for changes under REG_KEY and
+// wakes the UI thread, which re-reads the live settings and hands them to the workers
+static std::atomic<bool> g_SettingsChanged{ false };
+
+static void SettingsWatcher(HANDLE stop)
+{
+    HKEY hKey;
+    if (RegCreateKeyExW(HKEY_CURRENT_USER, REG_KEY, 0, NULL, 0, KEY_NOTIFY, NULL, &hKey, NULL) != ERROR_SUCCESS) return;
+    HANDLE changed = CreateEventW(NULL, FALSE, FALSE, NULL);
+    HANDLE waits[2] = { stop, changed };
+    // the notification is one-shot, re-armed before every wait
+    while (RegNotifyChangeKeyValue(hKey, FALSE, REG_NOTIFY_CHANGE_LAST_SET, changed, TRUE) == ERROR_SUCCESS &&
+        WaitForMultipleObjects(2, waits, FALSE, INFINITE) == WAIT_OBJECT_0 + 1)
+    {
+        g_SettingsChanged = true;
+        PostThreadMessageW(g_UiThreadId, WM_NULL, 0, 0);
+    }
+    CloseHandle(changed);
+    RegCloseKey(hKey);
+}
+
+// UI thread: new star counts per window, the power throttle recomputes rate and budget.
+// Speed, streaks, LOD and incremental drawing are atomics the workers read every frame.
+static void ReloadSettings()
+{
+    LoadLiveSettings();
+    for (auto rw : g_Windows)
+    {
+        if (rw->field) continue; // restart only, see UpdateField
+        // rw->rc belongs to the worker, the UI thread asks the window itself
+        RECT rc;
+        GetClientRect(rw->hwnd, &rc);
+        rw->starCount = StarsForArea(rc.right - rc.left, rc.bottom - rc.top);
+    }
+    ApplyPowerThrottle();
+    LogLine("[MyStarfield] settings reloaded: %d stars / 1080p, speed %d, fps %d, streaks %d, incremental %d, lod %d / %d",
+        (int)g_StarCount, (int)g_Speed, g_TargetFps, (int)g_Streaks, (int)g_Incremental, (int)g_LodPixel, (int)g_LodQuad);
+}
+
 // Run fullscreen
 static void RunFull()
 {
+    if (g_SharedField) g_Analytic = true; // nobody may step a field other workers read
     EnumDisplayMonitors(NULL, NULL, MonEnumProc, 0);
-    QueryPerformanceFrequency(&g_PerfFreq);
+    g_Shared.count = min(g_Shared.count, g_MaxStars);
+    for (auto rw : g_Windows) if (rw->field) UpdateSharedSlice(rw);
     QueryPerformanceCounter(&g_StartCounter);
     POINT p;
     GetCursorPos(&p);
     g_StartMouse = p;
     g_StartMouseInit = true;
-    LARGE_INTEGER last;
-    QueryPerformanceCounter(&last);
-    double total = 0.0;
+    g_UiThreadId = GetCurrentThreadId();
+    HANDLE inputReady = CreateEventW(NULL, TRUE, FALSE, NULL);
+    std::thread input(InputThread, inputReady);
+    WaitForSingleObject(inputReady, INFINITE);
+    CloseHandle(inputReady);
+    HANDLE watcherStop = CreateEventW(NULL, TRUE, FALSE, NULL);
+    std::thread watcher(SettingsWatcher, watcherStop);
+    // spare cores split big star fields into chunks, shared by all monitors
+    int cores = (int)std::thread::hardware_concurrency();
+    g_SimPool.Start(min(7, cores - 1));
+    for (auto rw : g_Windows)
+    {
+        rw->targetFps = g_TargetFps;
+        rw->worker = std::thread(RenderWorker, rw);
+    }
+    if (!g_Windows.empty()) RegisterPowerNotifications(g_Windows[0]->hwnd);
+    LARGE_INTEGER lastReport;
+    QueryPerformanceCounter(&lastReport);
     MSG msg;
+    // the UI thread only pumps messages and tracks visibility / power, workers pace themselves
     while (g_Running)
     {
-        while (PeekMessageW(&msg, NULL, 0, 0, PM_REMOVE))
+        MsgWaitForMultipleObjects(0, NULL, FALSE, STATE_POLL_MS, QS_ALLINPUT);
         {
-            if (msg.message == WM_QUIT)
+            ScopedTimer t(g_MainStats, PHASE_PUMP);
+            while (PeekMessageW(&msg, NULL, 0, 0, PM_REMOVE))
             {
-                g_Running = false;
-                break;
+                if (msg.message == WM_QUIT)
+                {
+                    g_Running = false;
+                    break;
+                }
+                TranslateMessage(&msg);
+                DispatchMessageW(&msg);
             }
-            TranslateMessage(&msg);
-            DispatchMessageW(&msg);
+        }
+        if (!g_Running) break;
+        if (g_SettingsChanged.exchange(false)) ReloadSettings();
+        if (g_Power.changed) ApplyPowerThrottle();
+        // nothing to show: display off, session locked, or the window hidden / cloaked
+        for (auto rw : g_Windows)
+        {
+            bool show = !g_Power.Suspended() && WindowShowing(rw->hwnd);
+            if (show && !rw->active.exchange(true)) SetEvent(rw->wake);
+            else if (!show) rw->active = false;
         }
         LARGE_INTEGER now;
         QueryPerformanceCounter(&now);
-        double dt = double(now.QuadPart - last.QuadPart) / double(g_PerfFreq.QuadPart);
-        last = now; 
-        total += dt;
-        for (auto rw : g_Windows) RenderFrame(rw, (float)dt, (float)total);
-        Sleep(8);
+        if (now.QuadPart - lastReport.QuadPart >= g_PerfFreq.QuadPart)
+        {
+            ReportPumpStats();
+            lastReport = now;
+        }
     }
+    g_Running = false;
+    // the desktop is back within a compositor frame, however long the workers' frames still take
+    for (auto rw : g_Windows) ShowWindow(rw->hwnd, SW_HIDE);
+    if (g_InputHwnd) PostMessageW(g_InputHwnd, WM_CLOSE, 0, 0);
+    input.join();
+    g_InputHwnd = NULL;
+    g_RawInput = false;
+    SetEvent(watcherStop);
+    watcher.join();
+    CloseHandle(watcherStop);
+    if (!g_Windows.empty()) UnregisterPowerNotifications(g_Windows[0]->hwnd);
+    for (auto rw : g_Windows)
+    {
+        SetEvent(rw->wake);
+        if (rw->worker.joinable()) rw->worker.join();
+    }
+    g_SimPool.Shutdown();
     for (auto rw : g_Windows)
     {
         DestroyBackbuffer(rw);
         if (rw->hwnd) DestroyWindow(rw->hwnd);
+        if (rw->wake) CloseHandle(rw->wake);
         delete rw;
     }
     g_Windows.clear();
@@ -561,6 +4191,7 @@ static int RunPreview(HWND parent)
 {
     if (!IsWindow(parent)) return 0;
     WNDCLASSW wc = {};
+    wc.style = CS_OWNDC;
     wc.lpfnWndProc = PreviewProc;
     wc.hInstance = g_Hinst;
     wc.lpszClassName = L"MyStarPre";
@@ -578,29 +4209,47 @@ static int RunPreview(HWND parent)
     rw->isPreview = true; 
     rw->rc = pr;
     std::random_device rd; 
-    rw->rng.seed(rd());
+    rw->rng.Seed(((uint64_t)rd() << 32) | rd());
+    // a thumbnail does not need a D3D device, the DIB path is plenty
+    rw->renderer.reset(MakeRenderer(g_RenderPath == RENDER_GDI ? RENDER_GDI : RENDER_DIB));
     CreateBackbuffer(rw);
+    SetWindowLongPtrW(child, GWLP_USERDATA, (LONG_PTR)rw);
+    rw->starCount = PreviewStarCount(pr);
     InitStars(rw);
     QueryPerformanceFrequency(&g_PerfFreq);
     LARGE_INTEGER last;
     QueryPerformanceCounter(&last);
     double total = 0.0; 
+    FrameScheduler sched;
+    sched.Init(g_TargetFps > 0 ? min(g_TargetFps, PREVIEW_FPS) : PREVIEW_FPS);
     MSG msg;
     while (IsWindow(child)) 
     {
+        sched.BeginFrame();
         while (PeekMessageW(&msg, NULL, 0, 0, PM_REMOVE))
         {
             if (msg.message == WM_QUIT) { DestroyWindow(child); break; }
             TranslateMessage(&msg); 
             DispatchMessageW(&msg);
         }
+        if (!IsWindow(child)) break;
+        if (!WindowShowing(child))
+        {
+            // paused: nothing simulated or drawn until a message or the next poll
+            MsgWaitForMultipleObjects(0, NULL, FALSE, PREVIEW_IDLE_POLL_MS, QS_ALLINPUT);
+            QueryPerformanceCounter(&last); // resume without a time jump
+            continue;
+        }
         LARGE_INTEGER now;
         QueryPerformanceCounter(&now);
         double dt = double(now.QuadPart - last.QuadPart) / double(g_PerfFreq.QuadPart);
         last = now; total += dt;
-        RenderFrame(rw, (float)dt, (float)total);
-        Sleep(15);
+        RenderFrame(rw, (float)dt, total);
+        PresentFrame(rw);
+        sched.EndFrame();
     }
+    sched.Close();
+    if (IsWindow(child)) SetWindowLongPtrW(child, GWLP_USERDATA, 0);
     DestroyBackbuffer(rw);
     DestroyWindow(child);
     UnregisterClassW(wc.lpszClassName, g_Hinst);
@@ -608,29 +4257,196 @@ static int RunPreview(HWND parent)
     return 0;
 }
 
+// ---- Headless benchmark: "/b [seed]" renders a fixed number of frames at a fixed dt
+// into an offscreen backbuffer for each renderer, star count and resolution, prints CSV.
+struct BenchResolution { int w, h; };
+static const BenchResolution g_BenchResolutions[] = { { 1280, 720 }, { 1920, 1080 }, { 2560, 1440 }, { 3840, 2160 } };
+static const int g_BenchStarCounts[] = { 1000, 3000, 10000, 50000, 200000 };
+static const RenderPath g_BenchPaths[] = { RENDER_GDI, RENDER_DIB, RENDER_D3D11 };
+static const int BENCH_WARMUP = 30;
+static const int BENCH_FRAMES = 300;
+static const float BENCH_DT = 1.0f / 60.0f;
+
+// stdout of the launching console (or a redirect), debug output as well
+static void BenchOut(const char* fmt, ...)
+{
+    static HANDLE out = NULL;
+    if (!out)
+    {
+        out = GetStdHandle(STD_OUTPUT_HANDLE);
+        if ((!out || out == INVALID_HANDLE_VALUE) && AttachConsole(ATTACH_PARENT_PROCESS)) out = GetStdHandle(STD_OUTPUT_HANDLE);
+        if (!out) out = INVALID_HANDLE_VALUE;
+    }
+    char buf[1024];
+    va_list args;
+    va_start(args, fmt);
+    int len = vsprintf_s(buf, fmt, args);
+    va_end(args);
+    if (len <= 0) return;
+    OutputDebugStringA(buf);
+    DWORD written = 0;
+    if (out != INVALID_HANDLE_VALUE) WriteFile(out, buf, (DWORD)len, &written, NULL);
+}
+
+// One configuration, false when the renderer is not available here
+static bool BenchRun(RenderPath path, int w, int h, int stars, uint32_t seed)
+{
+    RenderWindow* rw = new RenderWindow();
+    rw->rc = { 0, 0, w, h };
+    rw->renderer.reset(MakeRenderer(path));
+    if (!rw->renderer->Create(rw))
+    {
+        delete rw;
+        return false;
+    }
+    // same seed every run: identical star field and respawn sequence per configuration
+    rw->rng.Seed(seed);
+    g_SimPool.Reseed(seed);
+    g_StarCount = stars;
+    InitStars(rw);
+    LARGE_INTEGER start = {}, end;
+    for (int f = 0; f < BENCH_WARMUP + BENCH_FRAMES; ++f)
+    {
+        if (f == BENCH_WARMUP) QueryPerformanceCounter(&start);
+        RenderFrame(rw, BENCH_DT, (f + 1) * (double)BENCH_DT);
+        PresentFrame(rw);
+    }
+    QueryPerformanceCounter(&end);
+    double seconds = double(end.QuadPart - start.QuadPart) / double(g_PerfFreq.QuadPart);
+    double fps = BENCH_FRAMES / max(seconds, 1e-9);
+    BenchOut("%s,%s,%d,%d,%d,%d,%d,%d,%d,%d,%.4f,%.1f,%.0f,%.3f,%.3f,%.3f\n",
+        RenderPathName(path), g_Simd == SIMD_AVX2 ? "AVX2" : (g_Simd == SIMD_SSE2 ? "SSE2" : "scalar"),
+        g_SimPool.numSlots, (int)g_Incremental, (int)g_Analytic, (int)g_Compact, w, h, stars, BENCH_FRAMES, seconds, fps, fps * stars,
+        rw->stats.Summarize(PHASE_SIMULATE).p50, rw->stats.Summarize(PHASE_DRAW).p50, rw->stats.Summarize(PHASE_PRESENT).p50);
+    DestroyBackbuffer(rw);
+    delete rw;
+    return true;
+}
+
+static void RunBenchmark(uint32_t seed)
+{
+    int cores = (int)std::thread::hardware_concurrency();
+    g_SimPool.Start(min(7, cores - 1));
+    int savedStars = g_StarCount;
+    BenchOut("renderer,simd,threads,incremental,analytic,compact,width,height,stars,frames,seconds,fps,stars_per_sec,sim_p50_ms,draw_p50_ms,blit_p50_ms\n");
+    for (RenderPath path : g_BenchPaths)
+    {
+        for (const BenchResolution& res : g_BenchResolutions)
+        {
+            for (int stars : g_BenchStarCounts)
+            {
+                if (!BenchRun(path, res.w, res.h, stars, seed)) break;
+            }
+        }
+    }
+    g_StarCount = savedStars;
+    g_SimPool.Shutdown();
+}
+
+// ---- Offline capture: "/v[:frames]" renders the primary screen's size at a fixed dt from
+// seed 1 and encodes every frame, as fast as the encoder takes them.
+static void RunCapture(int frames)
+{
+    int w = max(2, GetSystemMetrics(SM_CXSCREEN) & ~1);
+    int h = max(2, GetSystemMetrics(SM_CYSCREEN) & ~1);
+    int fps = g_TargetFps > 0 ? g_TargetFps : 60;
+    double dt = 1.0 / fps;
+    RenderWindow* rw = new RenderWindow();
+    rw->rc = { 0, 0, w, h };
+    rw->renderer.reset(MakeRenderer(g_RenderPath));
+    if (!rw->renderer->Create(rw))
+    {
+        rw->renderer.reset(MakeRenderer(RENDER_DIB));
+        if (!rw->renderer->Create(rw))
+        {
+            BenchOut("capture: no renderer for %dx%d\n", w, h);
+            delete rw;
+            return;
+        }
+    }
+    std::wstring base = CaptureBasePath();
+    CaptureRing* ring = new CaptureRing();
+    if (!ring->Start(base.c_str(), w, h, fps, g_CapturePng))
+    {
+        BenchOut("capture: can't open %ws\n", base.c_str());
+        delete ring;
+        DestroyBackbuffer(rw);
+        delete rw;
+        return;
+    }
+    int cores = (int)std::thread::hardware_concurrency();
+    g_SimPool.Start(min(7, cores - 1));
+    rw->rng.Seed(1);
+    g_SimPool.Reseed(1);
+    rw->starCount = StarsForArea(w, h); // the saver's density at this size
+    InitStars(rw);
+    LARGE_INTEGER start, end;
+    QueryPerformanceCounter(&start);
+    for (int f = 0; f < frames; ++f)
+    {
+        RenderFrame(rw, (float)dt, (f + 1) * dt);
+        uint32_t* dst = ring->Acquire(true); // backpressure: wait for the encoder
+        if (rw->renderer->ReadFrame(rw, dst, w, h)) ring->Commit(f * 10000000LL / fps);
+        else ring->Drop();
+        PresentFrame(rw);
+    }
+    ring->Stop();
+    QueryPerformanceCounter(&end);
+    double seconds = double(end.QuadPart - start.QuadPart) / double(g_PerfFreq.QuadPart);
+    int written, dropped, queued;
+    ring->Counts(written, dropped, queued);
+    BenchOut("capture: %ws%s %dx%d %s, %d frames written, %d failed, %.1f s (%.2fx realtime)\n",
+        base.c_str(), g_CapturePng ? "_*.png" : ".mp4", w, h, RenderPathName(rw->renderer->Path()),
+        written, dropped, seconds, frames / (double)fps / max(seconds, 1e-9));
+    delete ring;
+    g_SimPool.Shutdown();
+    DestroyBackbuffer(rw);
+    delete rw;
+}
+
 // Entry point
 int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE, PWSTR, int) 
 {
+    QueryPerformanceCounter(&g_LaunchCounter);
     g_Hinst = hInstance;
+    // real pixels and per monitor DPI, windows are sized from rcMonitor
+    SetProcessDpiAwarenessContext(DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE_V2);
+    QueryPerformanceFrequency(&g_PerfFreq);
+    TraceLoggingRegister(g_TraceProvider);
     LoadSettings();
+    g_Simd = DetectSimd();
+    BuildDiscSprites();
     // log path for verification
     wchar_t modPath[MAX_PATH] = {};
     GetModuleFileNameW(NULL, modPath, MAX_PATH);
-    char pathLog[512];
-    sprintf_s(pathLog, "Running from: %ws", modPath);
+    LogLine("[MyStarfield] Running from: %ws", modPath);
     int argc = 0;
     wchar_t** argv = CommandLineToArgvW(GetCommandLineW(), &argc);
     wchar_t mode = 0;
-    HWND argH = NULL;
-    ParseArgs(argc, argv, mode, argH);
-    {
-        char buf[256];
-        sprintf_s(buf, "Parsed args mode=%c hwnd=%p", mode ? (char)mode : '0', argH);
-    }
+    unsigned long long argNum = 0;
+    ParseArgs(argc, argv, mode, argNum);
+    HWND argH = (HWND)(UINT_PTR)argNum;
+    ParseFlags(argc, argv);
+    LogLine("[MyStarfield] Parsed args mode=%c hwnd=%p hud=%d", mode ? (char)mode : '0', argH, (int)g_ShowHud);
     if (mode == 'c')
     {
         ShowSettingsModalPopup();
         LocalFree(argv); 
+        TraceLoggingUnregister(g_TraceProvider);
+        return 0;
+    }
+    if (mode == 'b')
+    {
+        RunBenchmark(argNum ? (uint32_t)argNum : 1u);
+        LocalFree(argv);
+        TraceLoggingUnregister(g_TraceProvider);
+        return 0;
+    }
+    if (mode == 'v')
+    {
+        RunCapture(argNum ? (int)argNum : CAPTURE_DEFAULT_FRAMES);
+        LocalFree(argv);
+        TraceLoggingUnregister(g_TraceProvider);
         return 0;
     }
     if (mode == 'p')
@@ -639,6 +4455,7 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE, PWSTR, int)
         {
             RunPreview(argH);
             LocalFree(argv); 
+            TraceLoggingUnregister(g_TraceProvider);
             return 0;
         }
     }
@@ -646,5 +4463,6 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE, PWSTR, int)
     g_Running = true;
     RunFull();
     LocalFree(argv);
+    TraceLoggingUnregister(g_TraceProvider);
     return 0;
 }
\ No newline at end of file